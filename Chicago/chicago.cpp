@@ -144,6 +144,7 @@ static uint32_t temp_value;
 
 //OCM auto-flash check flag, default value: on
 static uint8_t auto_flash_flag			= FLAG_VALUE_ON;
+static tagBurnHexAuto auto_flash_task;
 
 //For HPD signal
 static uint8_t set_HPD;
@@ -2213,6 +2214,9 @@ void chicago_state_change(ChicagoState state){
 			case STATE_NORMAL:
 				TRACE1("%s", "STATE_NORMAL");
 				break;
+			case STATE_AUTOFLASH:
+				TRACE1("%s", "STATE_AUTOFLASH");
+				break;
 			default:
 				TRACE1("%s", "ERROR_STATE");
 				break;			
@@ -2236,6 +2240,9 @@ void chicago_state_change(ChicagoState state){
 			case STATE_NORMAL:
 			TRACE1("%s\n", "STATE_NORMAL");
 			break;
+			case STATE_AUTOFLASH:
+			TRACE1("%s\n", "STATE_AUTOFLASH");
+			break;
 			default:
 			TRACE1("%s\n", "ERROR_STATE");
 			break;
@@ -2783,13 +2790,12 @@ void chicago_main(void){
 		#endif 
 		//}
 		
-		// OCM FW flash check				
+		// OCM FW flash check, a piece at a time from STATE_AUTOFLASH
 		if(auto_flash_flag == FLAG_VALUE_ON)
 		{
-			burn_hex_auto();
-			
-			// No need do auto-flash again
-			auto_flash_flag = FLAG_VALUE_OFF;
+			burn_hex_auto_begin(&auto_flash_task);
+			current_state = STATE_AUTOFLASH;
+			break;
 		}
 
 		// Enable /INT0 interrupts first
@@ -3080,6 +3086,21 @@ void chicago_main(void){
 		}
 		break;
 
+	case STATE_AUTOFLASH:
+		#ifdef	DEBUG_LEVEL_3
+			TRACE1("\t%s\n", "STATE_AUTOFLASH"); 
+		#endif
+
+		if(burn_hex_auto_step(&auto_flash_task) >= BURN_AUTO_DONE)
+		{
+			// No need do auto-flash again
+			auto_flash_flag = FLAG_VALUE_OFF;
+
+			// power Chicago up again from the start
+			current_state = STATE_NONE;
+		}
+		break;
+
 	// for debug only
 	case STATE_POWEROFF:
 		#ifdef	DEBUG_LEVEL_3
@@ -341,6 +341,7 @@
 		STATE_WAITCABLE,
 		STATE_CONNECTING,
 		STATE_NORMAL,
+		STATE_AUTOFLASH,	// burn_hex_auto_step() until it is done
 	}ChicagoState;
 
 	//-----------------------------------------------------------------------------
@@ -23,7 +23,10 @@
 #ifndef __CONFIG_H__
 	#define __CONFIG_H__
 	
-	#include "../../pin_settings.h"
+	// Host/ tools build the flash code without the board files
+	#ifdef ARDUINO
+		#include "../../pin_settings.h"
+	#endif
 	
 	#define _BIT0								0x01
 	#define _BIT1								0x02
@@ -77,6 +80,14 @@
 	#define SERIAL_SEND_BUF_SIZE				64
 	#define CMD_LINE_SIZE						128
 	#define CMD_NAME_SIZE						16
+
+	//    c) non-volatile storage for the flash programming journal (Flash/flashJournal.h);
+	//       comment these out to keep the journal in RAM only
+	#ifdef ARDUINO
+		#define FLASH_JOURNAL_EEPROM_ADDR		0
+		#define FLASH_JOURNAL_LOAD(journal)		EEPROM.get(FLASH_JOURNAL_EEPROM_ADDR, journal)
+		#define FLASH_JOURNAL_STORE(journal)	EEPROM.put(FLASH_JOURNAL_EEPROM_ADDR, journal)
+	#endif
 	
 	
 	#define POWERCYCLE_DELAY					250  // in miliseconds
@@ -149,6 +160,7 @@
 
 	#define DELAY_US(t)							delayMicroseconds(t);
 	#define delay_ms(t)							delay(t);
+	#define TIMESTAMP_US()						micros()
 
 	#define OFFSET(s, m)						(uint8_t) & (((s *) 0 ) -> m)
 
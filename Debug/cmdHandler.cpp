@@ -85,6 +85,12 @@ void CmdHandler(void){
 	if (g_bFlashWrite)
 	{
 		flash_program();
+
+		// a staged HEX file checked out, erase now and take it again
+		if (burn_hex_stage_ready() != 0)
+		{
+			burnhex_start(burn_hex_stage_ready());
+		}
 	}
 	else
 	{
@@ -233,10 +239,27 @@ void CmdHandler(void){
 					TRACE("\treadhex <base_address> <size_to_be_read>\n");
 				}
 			}
+			else if (strcmp((const char *)CommandName, "readbin") == 0)
+			{
+				power_restart();
+				if (sscanf((const char *)g_CmdLineBuf, "\\%*s %x %lx", &Flash_Addr, &size_to_be_read) == 2)
+				{
+					command_flash_read_bin(Flash_Addr, size_to_be_read);
+				}
+				else
+				{
+					TRACE("\tBad parameter! Usage:\n");
+					TRACE("\treadbin <base_address> <size_to_be_read>\n");
+				}
+			}
 			else if (strcmp((const char *)CommandName, "burnhex") == 0)
 			{
 				burnhex();
 			}
+			else if (strcmp((const char *)CommandName, "flashtime") == 0)
+			{
+				flash_timing_report();
+			}
 			else if (strcmp((const char *)CommandName, "ocmversion") == 0)
 			{
 				// read current OCM version
@@ -418,7 +441,7 @@ static void help(void)
 	TRACE("\t\\resetup \\resetdown \\showmipi \\showmipitx \\showdprx \\panelon\n");
     TRACE("\t\\paneloff \\stopocm \\startocm \\ocmversion \\readintr \n\n");	
 
-	TRACE("\t\\fl_se \\fl_ce \\erase \\readhex \\burnhex\n");
+	TRACE("\t\\fl_se \\fl_ce \\erase \\readhex \\readbin \\burnhex \\flashtime\n");
 }
 
 //-----------------------------------------------------------------------------
@@ -645,11 +668,23 @@ static void man(void)
 			TRACE("\tFunction: read OCM hex file\n");
 			TRACE("\tUsage: \\readhex\n");
 		}
+		else if (strcmp((const char *)CommandName, "readbin") == 0)
+		{
+			TRACE("\tCommand: readbin\n");
+			TRACE("\tFunction: read flash as CRC32 framed binary, receive with Host/flash_dump\n");
+			TRACE("\tUsage: \\readbin <base_address> <size_to_be_read>\n");
+		}
 		else if (strcmp((const char *)CommandName, "burnhex") == 0)
 		{
 			TRACE("\tCommand: burnhex\n");
 			TRACE("\tFunction: Erase & burn flash hex file\n");
-			TRACE("\tUsage: \\burnhex <The combination value of partition IDs, value from 0x1 to 0x7>\n");
+			TRACE("\tUsage: \\burnhex <The combination value of partition IDs, value from 0x1 to 0x7> [stage]\n");
+		}
+		else if (strcmp((const char *)CommandName, "flashtime") == 0)
+		{
+			TRACE("\tCommand: flashtime\n");
+			TRACE("\tFunction: print per-phase timing and poll counts of the last flash burn\n");
+			TRACE("\tUsage: \\flashtime\n");
 		}
 		else if (strcmp((const char *)CommandName, "ocmversion") == 0)
 		{
@@ -1345,23 +1380,29 @@ static void start_ocm(void){
 /// @copydoc burnhex
 static void burnhex(void){
 	uint32_t partition_ids = 0;
-	uint8_t id;
-	int total_num = PARTITION_ID_MAX;
+	uint8_t mode[8];
+	int params;
 
-	if (sscanf((const char *)g_CmdLineBuf, "\\%*s %x", &partition_ids) == 1)
+	params = sscanf((const char *)g_CmdLineBuf, "\\%*s %x %7s", &partition_ids, mode);
+	if (params >= 1)
 	{
 		if ((partition_ids == 0) || (partition_ids > 0x7)) {
 			goto invalid_para;
 		}
 
-		power_restart();
-		for (id = 0; id < total_num; id++) {
-			if (partition_ids & (0x1 << id)) {
-				command_erase_partition(id);
+		if (params == 2)
+		{
+			MakeLower(mode);
+			if (strcmp((const char *)mode, "stage") != 0) {
+				goto invalid_para;
 			}
+
+			// check the whole file first, burnhex_start() runs once it is good
+			burn_hex_stage_prepare((uint8_t)partition_ids);
+			return;
 		}
-		burn_hex_prepare();
-		delay_ms(1000);
+
+		burnhex_start((uint8_t)partition_ids);
 		return;
 	}
 
@@ -1374,7 +1415,25 @@ invalid_para:
 	TRACE("bit 2: HDCP 1.4 & 2.2 key --> 0x4\n");
 	TRACE("Example: value '1' for Main OCM FW only\n");
 	TRACE("Example: value '3' for Main OCM FW + Secure OCM FW\n");
-	TRACE("Example: value '7' for Main OCM FW + Secure OCM FW + HDCP 1.4 & 2.2 key\n\n");
+	TRACE("Example: value '7' for Main OCM FW + Secure OCM FW + HDCP 1.4 & 2.2 key\n");
+	TRACE("Add 'stage' to check the whole file before anything is erased, then send it again\n");
+	TRACE("Example: \\burnhex 1 stage\n\n");
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc burnhex_start
+static void burnhex_start(uint8_t partition_ids){
+	uint8_t id;
+	int total_num = PARTITION_ID_MAX;
+
+	power_restart();
+	for (id = 0; id < total_num; id++) {
+		if (partition_ids & (0x1 << id)) {
+			command_erase_partition(id);
+		}
+	}
+	burn_hex_prepare();
+	delay_ms(1000);
 }
 
 //-----------------------------------------------------------------------------
@@ -269,10 +269,19 @@
 	  * @brief 
 	  *		Reflashes the Chicago on chip micro controller
 	  * @ingroup Chicago_cmdline
-	  * @note Command line usage: \\burnhex (combination value of partition IDs, value from 0x1 to 0x7)
+	  * @note Command line usage: \\burnhex (combination value of partition IDs, value from 0x1 to 0x7) [stage]
 	  * @return void
 	  */		
 	static void burnhex(void);
+
+	/**
+	  * @brief 
+	  *		Erase the partitions and wait for the HEX file to program
+	  * @ingroup Chicago_Debug_Internal
+	  * @param partition_ids - One bit per PARTITION_ID
+	  * @return void
+	  */		
+	static void burnhex_start(uint8_t partition_ids);
 	
 	/**
 	  * @brief 
@@ -114,6 +114,11 @@
 	#define TRACE9(format, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9)    \
 		Serial.printf(format, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9)
 
+	///	@brief Write raw bytes, for binary transfers
+	///	@ingroup Chicago_debug_internal
+	#define TRACE_BIN(buf, len)    \
+		Serial.write(buf, len)
+
 	#define ASSERT(expr)  \
 		if(expr){}  \
 		else{  \
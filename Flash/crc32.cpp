@@ -0,0 +1,56 @@
+/**
+* @file crc32.cpp
+*
+* @brief CRC-32 (IEEE 802.3) helper
+*
+* @copyright
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* @copyright
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* @author Adam Munich
+*/
+
+//#############################################################################
+// Includes
+//-----------------------------------------------------------------------------
+#include <stdint.h>
+
+#include "./crc32.h"
+
+
+//#############################################################################
+// Variable Declarations
+//-----------------------------------------------------------------------------
+// Reflected polynomial 0xEDB88320, one entry per nibble
+static uint32_t const CRC32_NIBBLE_TABLE[16] = {
+	0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+	0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+	0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+	0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+
+//#############################################################################
+// Function Definitions
+//-----------------------------------------------------------------------------
+uint32_t crc32_update(uint32_t Crc, const uint8_t *pData, uint32_t Length){
+
+	Crc = ~Crc;
+
+	while (Length--){
+		Crc ^= *pData++;
+		Crc = (Crc >> 4) ^ CRC32_NIBBLE_TABLE[Crc & 0x0F];
+		Crc = (Crc >> 4) ^ CRC32_NIBBLE_TABLE[Crc & 0x0F];
+	}
+
+	return ~Crc;
+}
@@ -0,0 +1,50 @@
+/**
+* @file crc32.h
+*
+* @brief CRC-32 (IEEE 802.3) helper _H
+*
+* @copyright
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* @copyright
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* @author Adam Munich
+*/
+
+#ifndef __CRC32_H__
+	#define __CRC32_H__
+
+	//#############################################################################
+	// Pre-compiler Definitions
+	//-----------------------------------------------------------------------------
+	// Seed for the first crc32_update() call
+	#define CRC32_INITIAL					0x00000000UL
+
+
+	//#############################################################################
+	// Function Prototypes
+	//-----------------------------------------------------------------------------
+	/**
+	 * @brief 
+	 *		Continue a CRC-32 over another block of data
+	 * @details
+	 *		Same polynomial, reflection and final XOR as zlib's crc32(), so the
+	 *		result of a chain of calls seeded with CRC32_INITIAL can be checked
+	 *		against any host tool. Nibble-table driven to keep the table at 64 bytes.
+	 * @ingroup Chicago_flash
+	 * @param Crc - Result of the previous call, or CRC32_INITIAL
+	 * @param pData - Data to add
+	 * @param Length - Number of bytes in pData
+	 * @return uint32_t - Updated CRC
+	 */
+	uint32_t crc32_update(uint32_t Crc, const uint8_t *pData, uint32_t Length);
+
+#endif  /* __CRC32_H__ */
@@ -29,6 +29,9 @@
 
 #include "./flash.h"
 #include "./hexFile.h"
+#include "./ocmImage.h"
+#include "./crc32.h"
+#include "./flashJournal.h"
 
 #include "../Chicago/chicago_config.h"
 #include "../Chicago/chicago.h"
@@ -48,6 +51,25 @@
 // SRP0 = 0
 #define  SW_FLASH_PROTECTION_PATTERN   ( FLASH_PROTECTION_ALL )
 
+// burn_hex_auto_offset(): no image data at this address
+#define  HEX_OFFSET_NONE               0xFFFFFFFFUL
+
+// tagFlashEngine: no sector / block yet
+#define  FLASH_ENGINE_NONE             0xFFFFFFFFUL
+
+// tagFlashEngine.sector_mode
+#define  FLASH_ENGINE_SECTOR_PROGRAM   0	// write and, with FLASH_ENGINE_VERIFY, read back
+#define  FLASH_ENGINE_SECTOR_CHECK     1	// journal says verified, read back only
+#define  FLASH_ENGINE_SECTOR_SKIP      2	// journal says verified, ignore
+
+#define  FLASH_ENGINE_SECTOR_BIT(addr) ((uint16_t)1 << (((addr) / FLASH_SECTOR_SIZE) % 16))
+
+// a resumed sector may fail its re-check once per sector before we give up
+#define  FLASH_ENGINE_RESUME_RETRIES   (FLASH_JOURNAL_SECTORS)
+
+// add the time since start to one g_FlashTiming phase
+#define  FLASH_TIMING_ADD(field, start)	(g_FlashTiming.field += TIMESTAMP_US() - (start))
+
 
 //#############################################################################
 // Variable Declarations
@@ -61,8 +83,32 @@ extern tagFlashRWinfo g_FlashRWinfo;
 
 extern uint8_t g_CmdLineBuf[CMD_LINE_SIZE];
 
-uint8_t const OCM_FW_DATA[]= {
-	#include "ocm_hex.h"
+tagFlashTiming g_FlashTiming;
+
+// progress callback, kept across burns
+static tagFlashProgressState g_FlashProgress;
+
+// \burnhex <ids> stage, between the check pass and the programming pass
+static tagFlashStage g_FlashStage;
+
+// indexed by FLASH_OP_xxx
+static const tagFlashOpTime g_FlashOpTime[FLASH_OP_COUNT] = {
+	{ 0,							FLASH_TIME_PAGE_PROGRAM_MAX },	// FLASH_OP_IDLE
+	{ FLASH_TIME_PAGE_PROGRAM_TYP,	FLASH_TIME_PAGE_PROGRAM_MAX },
+	{ FLASH_TIME_SECTOR_ERASE_TYP,	FLASH_TIME_SECTOR_ERASE_MAX },
+	{ FLASH_TIME_BLOCK_ERASE_TYP,	FLASH_TIME_BLOCK_ERASE_MAX },
+	{ FLASH_TIME_CHIP_ERASE_TYP,	FLASH_TIME_CHIP_ERASE_MAX },
+	{ FLASH_TIME_STATUS_WRITE_TYP,	FLASH_TIME_STATUS_WRITE_MAX },
+};
+
+// the HEX-over-console run, fed one line per flash_program() call
+static tagFlashEngine g_FlashEngine;
+
+// HDCP_LOAD_STATUS bits the boot loader sets for a good partition, indexed by PARTITION_ID
+static const uint8_t g_PartitionCrcBits[PARTITION_ID_MAX] = {
+	OCM_FW_CRC32,							// MAIN_OCM
+	HDCP_22_FW_CRC32,						// SECURE_OCM
+	HDCP_14_KEY_CRC32 | HDCP_22_KEY_CRC32,	// HDCP_14_22_KEY
 };
 
 
@@ -70,262 +116,63 @@ uint8_t const OCM_FW_DATA[]= {
 // Function Definitions
 //-----------------------------------------------------------------------------
 void flash_program(void){
-	
 	uint8_t WriteDataBuf[MAX_BYTE_COUNT_PER_RECORD_FLASH];
 	uint8_t ByteCount;
 	uint32_t  Address;
 	uint8_t RecordType;
-	uint8_t i;  /* counter */
-	uint8_t  RegBak1, RegBak2;  // register values back up
-	uint8_t  RegVal;			// register value
 	int8_t  return_code = 0;
 
-	#ifdef FALSH_READ_BACK
-		uint32_t  read_Address;
-		uint8_t read_ByteCount;
-		uint8_t read_Count;
-		uint8_t /* xdata */ ReadDataBuf[FLASH_READ_MAX_LENGTH];
-		uint8_t read_result;
-	#endif
-	
-	// stop secure OCM to avoid buffer access conflict
-	i2c_read_byte(SLAVEID_DP_IP, ADDR_HDCP2_CTRL, &RegVal);
-	RegBak1 = RegVal;
-	RegVal &= (~HDCP2_FW_EN);
-	i2c_write_byte(SLAVEID_DP_IP, ADDR_HDCP2_CTRL, RegVal);
-
-	// TODO
-	// stop main OCM to avoid buffer access conflict
-	i2c_read_byte(SLAVEID_SPI, OCM_DEBUG_CTRL, &RegVal);
-	RegBak2 = RegVal;
-	RegVal |= OCM_RESET;
-	i2c_write_byte(SLAVEID_SPI, OCM_DEBUG_CTRL, RegVal);  
-
-	flash_wait_until_flash_SM_done();
-
-	i2c_write_byte(SLAVEID_SPI, R_FLASH_LEN_H, (FLASH_WRITE_MAX_LENGTH - 1) >> 8);
-	i2c_write_byte(SLAVEID_SPI, R_FLASH_LEN_L, (FLASH_WRITE_MAX_LENGTH - 1) & 0xFF);
-
-	/* ================================ Ping: accumulates data ================================ */
-	if (g_FlashRWinfo.prog_is_Ping){
-		return_code = GetLineData(g_CmdLineBuf, &ByteCount, &Address, &RecordType, WriteDataBuf);
-		HEX_file_validity_check(Address, ByteCount, return_code);
-
-		/* end of HEX file */
-		if (RecordType == HEX_RECORD_TYPE_EOF){
-			g_bFlashWrite = 0;
-
-			#ifdef FALSH_READ_BACK
-				if(g_bFlashResult == 1){
-					TRACE("Flash ERROR!!! read back data was not the same as write data\n");
-					TRACE("Please burn again.\n\n");
-				}
-				else{
-			#endif				
-			
-			TRACE1("\n\n>ping>Flash program done. %lu bytes written.\n\n", g_FlashRWinfo.total_bytes_written);
-			TRACE("You MUST power cycle the EVB now.\n\n");
-			
-			#ifdef FALSH_READ_BACK
-				}
-			#endif
-			
-			// TODO: start a timer to check how much time it takes to program the Flash
-			flash_HW_write_protection_enable();
-			return;
-		}
-
-	write_prepare_in_ping:
-		flash_write_prepare(Address, (uint8_t)0, ByteCount, &WriteDataBuf[0]);
-		
-		#ifdef FALSH_READ_BACK
-			read_Address = Address;
-			flash_writedata_keep(&WriteDataBuf[0], &ReadDataBuf[0], ByteCount);
-			read_ByteCount = ByteCount;
-		#endif
-		
-		g_FlashRWinfo.previous_addr = Address;
-
-		g_FlashRWinfo.bytes_accumulated_in_Ping = ByteCount;
-		g_FlashRWinfo.prog_is_Ping = 0;
-
-		// We're now in ping, but we have to do something that is normally done in pong (the Address dictates this),
-		if ((Address % FLASH_WRITE_MAX_LENGTH) != 0) {
-			// so that we can recover the ping-pong cadence.
-			
-			for (i=0; i<MAX_BYTE_COUNT_PER_RECORD_FLASH; i++){
-				i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_0 + i, 0xFF);
-			}
-			
-			flash_write_prepare(Address - MAX_BYTE_COUNT_PER_RECORD_FLASH, (uint8_t)MAX_BYTE_COUNT_PER_RECORD_FLASH, ByteCount, &WriteDataBuf[0]);
-			flash_actual_write();
-			
-			g_FlashRWinfo.total_bytes_written += ByteCount;
-			g_FlashRWinfo.bytes_accumulated_in_Ping = 0;
-			g_FlashRWinfo.prog_is_Ping = 1;
-			g_FlashRWinfo.previous_addr = Address;
-		}
-		
+	if (g_bFlashWrite == FLASH_WRITE_STAGE){
+		burn_hex_stage_line();
 		return;
 	}
 
-	/* ================================ Pong: program Flash ================================ */
 	/* note: GetLineData() can ONLY be called ONCE per flash_program() invoke, */
 	/* otherwise serial port buffer has no chance to be updated, and the same HEX record is used twice, */
 	/* which is incorrect. */
-	if (!g_FlashRWinfo.prog_is_Ping){
-		
-		return_code = GetLineData(g_CmdLineBuf, &ByteCount, &Address, &RecordType, WriteDataBuf);
-		HEX_file_validity_check(Address, ByteCount, return_code);
-
-		/* end of HEX file */
-		if (RecordType == HEX_RECORD_TYPE_EOF){
-			for (i=0; i<MAX_BYTE_COUNT_PER_RECORD_FLASH; i++){
-				i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_0 + MAX_BYTE_COUNT_PER_RECORD_FLASH + i, 0xFF);
-            }
-			
-			flash_actual_write();
-			
-			g_FlashRWinfo.total_bytes_written += g_FlashRWinfo.bytes_accumulated_in_Ping;
-			g_bFlashWrite = 0;
-
-			#ifdef FALSH_READ_BACK
-				if(1==g_bFlashResult){
-					TRACE("Flash ERROR!!! read back data was not the same as write data\n");
-					TRACE("Please burn again.\n\n");
-				}
-				else{
-			#endif				
-			
-			TRACE1("\n\n>pong>Flash program done. %lu bytes written.\n", g_FlashRWinfo.total_bytes_written);
-			TRACE("You MUST power cycle the EVB now.\n\n");
-
-			#ifdef FALSH_READ_BACK
-				}
-			#endif			
-			
-			// TODO: start a timer to check how much time it takes to program the Flash
-			flash_HW_write_protection_enable();
-			return;
-		}
+	return_code = GetLineData(g_CmdLineBuf, &ByteCount, &Address, &RecordType, WriteDataBuf);
+	HEX_file_validity_check(Address, ByteCount, return_code);
 
-		if (((Address % FLASH_WRITE_MAX_LENGTH) != 0) && (Address == g_FlashRWinfo.previous_addr + MAX_BYTE_COUNT_PER_RECORD_FLASH)){
-		    
-			// contiguous address			
-			for (i=0; i<ByteCount; i++){
-				i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_0 + g_FlashRWinfo.bytes_accumulated_in_Ping + i, WriteDataBuf[i]);			
-			}
-						
-			#ifdef FALSH_READ_BACK
-				flash_writedata_keep(&WriteDataBuf[0], &ReadDataBuf[g_FlashRWinfo.bytes_accumulated_in_Ping], ByteCount);
-				read_ByteCount += ByteCount;
-			#endif
-			
-			flash_actual_write();
-			
-			g_FlashRWinfo.total_bytes_written += (g_FlashRWinfo.bytes_accumulated_in_Ping + ByteCount);
-			g_FlashRWinfo.bytes_accumulated_in_Ping = 0;
-			g_FlashRWinfo.previous_addr = Address;
-			g_FlashRWinfo.prog_is_Ping = 1;
-		}
-		
-		else if (((Address % FLASH_WRITE_MAX_LENGTH) != 0) && (Address != g_FlashRWinfo.previous_addr + MAX_BYTE_COUNT_PER_RECORD_FLASH)){
-			// address is not contiguous
-			for (i=0; i<MAX_BYTE_COUNT_PER_RECORD_FLASH; i++){
-				i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_0 + MAX_BYTE_COUNT_PER_RECORD_FLASH + i, 0xFF);
-			}
-			
-			flash_write_enable();
-			
-			i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_H, g_FlashRWinfo.previous_addr >> 8);
-			i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_L, g_FlashRWinfo.previous_addr & 0xFF);
-			flash_actual_write();  // write what was received in ping
-			g_FlashRWinfo.total_bytes_written += g_FlashRWinfo.bytes_accumulated_in_Ping;
-			g_FlashRWinfo.bytes_accumulated_in_Ping = 0;
+	/* end of HEX file */
+	if (RecordType == HEX_RECORD_TYPE_EOF){
+		g_bFlashWrite = FLASH_WRITE_OFF;
 
-			for (i=0; i<MAX_BYTE_COUNT_PER_RECORD_FLASH; i++){
-				i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_0 + i, 0xFF);
-            }
-			
-			flash_write_prepare(Address - MAX_BYTE_COUNT_PER_RECORD_FLASH, (uint8_t)MAX_BYTE_COUNT_PER_RECORD_FLASH, ByteCount, &WriteDataBuf[0]);
-			flash_actual_write();  // write what is received in this pong
-			g_FlashRWinfo.total_bytes_written += ByteCount;
-			g_FlashRWinfo.previous_addr = Address;
-			g_FlashRWinfo.prog_is_Ping = 1;
+		if (flash_engine_end(&g_FlashEngine) != RETURN_NORMAL_VALUE){
+			TRACE("Flash ERROR!!! read back data was not the same as write data\n");
+			TRACE("Please burn again.\n\n");
 		}
-		
-		else if (((Address % FLASH_WRITE_MAX_LENGTH) == 0) && (Address != g_FlashRWinfo.previous_addr + MAX_BYTE_COUNT_PER_RECORD_FLASH)){
-			for (i=0; i<MAX_BYTE_COUNT_PER_RECORD_FLASH; i++){
-				i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_0 + MAX_BYTE_COUNT_PER_RECORD_FLASH + i, 0xFF);
-			}
-			
-			flash_write_enable();
-			
-			i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_H, g_FlashRWinfo.previous_addr >> 8);
-			i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_L, g_FlashRWinfo.previous_addr & 0xFF);
-			
-			flash_actual_write();  // write what was received in ping
-			g_FlashRWinfo.total_bytes_written += g_FlashRWinfo.bytes_accumulated_in_Ping;
-			g_FlashRWinfo.bytes_accumulated_in_Ping = 0;
-			goto write_prepare_in_ping;
+		else if ((g_FlashStage.state == FLASH_STAGE_PROGRAMMING) &&
+				 ((g_FlashStage.crc != g_FlashStage.staged_crc) || (g_FlashStage.bytes != g_FlashStage.staged_bytes))){
+			TRACE2("Flash ERROR!!! this transfer (%lu bytes, CRC32 %08lX) differs from the checked one\n",
+				g_FlashStage.bytes, g_FlashStage.crc);
+			TRACE("Please burn again.\n\n");
 		}
-		
 		else{
-			TRACE("Internal ERROR in flash_program()\n");
-			TRACE("Please power cycle the EVB and check the HEX file!\n");
-			while(1);  /* hangs deliberately so that the user can see it */
+			TRACE1("\n\nFlash program done. %lu bytes written.\n", g_FlashRWinfo.total_bytes_written);
+			TRACE("You MUST power cycle the EVB now.\n\n");
 		}
-		
-		#ifdef FALSH_READ_BACK
-			// read Flash data back
-			//flash_wait_until_flash_SM_done();
-	
-			/* =============== Reads 32 bytes =============== */
-			if(read_ByteCount>(MAX_BYTE_COUNT_PER_RECORD_FLASH*2)){
-				read_Count = (MAX_BYTE_COUNT_PER_RECORD_FLASH*2);
-			}else{
-				read_Count=read_ByteCount;
-			}
 
-			i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_H, read_Address >> 8);
-			i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_L, read_Address & 0xFF);
+		g_FlashStage.state = FLASH_STAGE_NONE;
 
-			i2c_write_byte(SLAVEID_SPI, R_FLASH_LEN_H, 0);
-			i2c_write_byte(SLAVEID_SPI, R_FLASH_LEN_L, FLASH_READ_MAX_LENGTH - 1);
+		FLASH_TIMING_ADD(total_us, g_FlashTiming.start_us);
+		flash_timing_report();
+		return;
+	}
 
-			ocm_read_enable();
-			flash_wait_until_flash_SM_done();
-			
-			TRACE("Read:");
-			for (i=0; i<read_Count; i++){
-				i2c_read_byte(SLAVEID_SPI, FLASH_READ_D0 + i, &read_result);
-				
-				TRACE1("%B02X",read_result);
-				if(read_result!=ReadDataBuf[i]){
-					g_bFlashResult = 1;
-				}
-			}
-		#endif
+	if (g_FlashStage.state == FLASH_STAGE_PROGRAMMING){
+		burn_hex_stage_add(Address, &WriteDataBuf[0], ByteCount);
 	}
 
-	// restore register value
-	i2c_write_byte(SLAVEID_DP_IP, ADDR_HDCP2_CTRL, RegBak1);  
-	
-	// TODO
-	// restore register value
-	i2c_write_byte(SLAVEID_SPI, OCM_DEBUG_CTRL, RegBak2);  
+	// a failed block is remembered by the engine and reported at EOF
+	flash_engine_write(&g_FlashEngine, Address, &WriteDataBuf[0], ByteCount);
 }
 
 //-----------------------------------------------------------------------------
 void command_flash_SE(uint32_t Flash_Addr){
 	flash_write_protection_disable();
-	flash_sector_erase(Flash_Addr);
-
-	#ifndef  DRY_RUN
-		flash_wait_until_WIP_cleared();
-	#endif
-
-	flash_wait_until_flash_SM_done();
+	if(flash_erase_sector(Flash_Addr) != RETURN_NORMAL_VALUE){
+		TRACE("Sector erase timed out!\n");
+	}
 	
 	TRACE2("Sector erase done: 0x%04X ~ 0x%04X\n", (Flash_Addr >> 12) * FLASH_SECTOR_SIZE,
 		( (Flash_Addr + FLASH_SECTOR_SIZE) >> 12) * FLASH_SECTOR_SIZE - 1);
@@ -350,53 +197,49 @@ void command_erase_partition(uint8_t part_id){
 		return;
 	}
 
+	flash_partition_bounds(part_id, &base_addr, &end_addr);
+
 	flash_write_protection_disable();
 
-	switch (part_id) {
-		case MAIN_OCM:
-			base_addr = MAIN_OCM_FW_ADDR_BASE;
-			end_addr = MAIN_OCM_FW_ADDR_END;
-			break;
-		case SECURE_OCM:
-			base_addr = SECURE_OCM_FW_ADDR_BASE;
-			end_addr = SECURE_OCM_FW_ADDR_END;
-			break;
-		case HDCP_14_22_KEY:
-			base_addr = HDCP_14_22_KEY_ADDR_BASE;
-			end_addr = HDCP_14_22_KEY_ADDR_END;
-			break;
-		default:
+	for (Flash_Addr = base_addr; Flash_Addr <= end_addr; Flash_Addr += FLASH_SECTOR_SIZE) {
+		if (flash_erase_sector(Flash_Addr) != RETURN_NORMAL_VALUE) {
+			TRACE1("Sector erase timed out at 0x%04X!\n", Flash_Addr);
 			break;
+		}
 	}
 
-	for (Flash_Addr = base_addr; Flash_Addr <= end_addr; Flash_Addr += FLASH_SECTOR_SIZE) {
-		flash_sector_erase(Flash_Addr);
-
-		#ifndef  DRY_RUN
-			flash_wait_until_WIP_cleared();
-		#endif
-
-		flash_wait_until_flash_SM_done();
+	if (Flash_Addr > end_addr) {
+		TRACE1("%s erased.\n", str[part_id]);
 	}
 
-	TRACE1("%s erased.\n", str[part_id]);
-
 	flash_HW_write_protection_enable();
 }
 
 //-----------------------------------------------------------------------------
 void command_flash_CE(void){
+	uint32_t timestamp;
+	int8_t return_code = RETURN_NORMAL_VALUE;
 	
 	flash_write_protection_disable();
+
+	timestamp = TIMESTAMP_US();
 	flash_chip_erase();
 	
 	#ifndef  DRY_RUN
-		flash_wait_until_WIP_cleared();
+		return_code = flash_wait_until_WIP_cleared(FLASH_OP_CHIP_ERASE);
 	#endif
 	
-	flash_wait_until_flash_SM_done();
+	if(flash_wait_until_flash_SM_done() != RETURN_NORMAL_VALUE){
+		return_code = RETURN_FAILURE_VALUE;
+	}
+	FLASH_TIMING_ADD(erase_us, timestamp);
 	
-	TRACE("Whole Flash chip erased.\n");
+	if(return_code == RETURN_NORMAL_VALUE){
+		TRACE("Whole Flash chip erased.\n");
+	}
+	else{
+		TRACE("Chip erase timed out, the flash is still busy!\n");
+	}
 	flash_HW_write_protection_enable();
 }
 
@@ -437,18 +280,8 @@ void command_flash_read(uint32_t Address, uint64_t size_to_be_read){
 	TRACE2("Start to read HEX from 0x%04X, size 0x%LX\n", Address, size_to_be_read);
 		
 	while(size_to_be_read!=0){
-		i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_H, Address >> 8);
-		i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_L, Address & 0xFF);
-		i2c_write_byte(SLAVEID_SPI, R_FLASH_LEN_H, 0);
-		i2c_write_byte(SLAVEID_SPI, R_FLASH_LEN_L, FLASH_READ_MAX_LENGTH - 1);  // Reads 32 bytes
-
-		ocm_read_enable();
-		flash_wait_until_flash_SM_done();
-
 		/* =============== Reads 32 bytes =============== */
-		for (i=0; i<FLASH_READ_MAX_LENGTH; i++){
-			i2c_read_byte(SLAVEID_SPI, FLASH_READ_D0 + i, &ReadDataBuf[i]);
-		}
+		flash_read_block(Address, &ReadDataBuf[0]);
 
 		ReadDataPtr = &ReadDataBuf[0];
 		for(j=0;j<2;j++){
@@ -483,393 +316,1409 @@ void command_flash_read(uint32_t Address, uint64_t size_to_be_read){
 }
 
 //-----------------------------------------------------------------------------
-void burn_hex_prepare(void){
-	
-	TRACE("You may send the HEX file now. SecureCRT -> Transfer -> Send ASCII ...\n");
-	g_bFlashWrite = 1;
+void command_flash_read_bin(uint32_t Address, uint32_t size_to_be_read){
+	uint8_t  FrameBuf[FLASH_DUMP_FRAME_DATA_SIZE];
+	uint32_t frame_address;
+	uint16_t frame_length;
+	uint16_t chunk;
+	uint32_t crc;
+	uint8_t  RegBak1, RegBak2;  // register values back up
+	uint8_t  RegVal;  // register value
 
-	#ifdef FALSH_READ_BACK
-		g_bFlashResult = 0;
-	#endif
+	if (Address%MAX_BYTE_COUNT_PER_RECORD_FLASH != 0){
+		TRACE2("ERROR! Address = 0x%04X, not %bu bytes aligned.\n", Address, MAX_BYTE_COUNT_PER_RECORD_FLASH);
+		return;
+	}
 
-    g_FlashRWinfo.total_bytes_written = 0;
-    g_FlashRWinfo.prog_is_Ping = 1;
-    flash_write_protection_disable();
+	// stop secure OCM to avoid buffer access conflict
+	i2c_read_byte(SLAVEID_DP_IP, ADDR_HDCP2_CTRL, &RegVal);
+	RegBak1 = RegVal;
+	RegVal &= (~HDCP2_FW_EN);
+	i2c_write_byte(SLAVEID_DP_IP, ADDR_HDCP2_CTRL, RegVal);
 
-    TRACE("Please make sure line send delay (SecureCRT -> Options -> Session Options -> Terminal\n");
-    TRACE("-> Emulation -> Advanced -> Line Send Delay) is set to enough long (Chicago: at least 5ms for 1MHz I2C)\n");
-    TRACE("before you select HEX file and transfer it.\n");
-}
+	// stop main OCM to avoid buffer access conflict
+	i2c_read_byte(SLAVEID_SPI, OCM_DEBUG_CTRL, &RegVal);
+	RegBak2 = RegVal;
+	RegVal |= OCM_RESET;
+	i2c_write_byte(SLAVEID_SPI, OCM_DEBUG_CTRL, RegVal);
 
-//-----------------------------------------------------------------------------
-uint8_t burn_hex_auto(void){	
-	
-	uint8_t reg_temp;
-	uint8_t current_version[3];
-	uint8_t hex_version[3];
-	uint8_t update_flag;
-	uint8_t i;
-	uint32_t hex_index;
-	uint32_t hex_lines;
-	
-	uint8_t WriteDataBuf[MAX_BYTE_COUNT_PER_RECORD_FLASH];
-	uint8_t ByteCount;
-	uint32_t  Address;
-	uint8_t RecordType;
-	uint8_t RegBak1, RegBak2;		// register values back up
-	uint8_t RegVal;				// register value
+	flash_wait_until_flash_SM_done();
 
-	uint32_t  read_Address;
-	uint8_t read_ByteCount;
-	uint8_t read_Count;
-	uint8_t ReadDataBuf[FLASH_READ_MAX_LENGTH];
-	uint8_t read_result;
+	TRACE2("Start to read BIN from 0x%04X, size 0x%lX\n", Address, size_to_be_read);
 
-	// RESET chicago first
-	chicago_power_onoff(CHICAGO_TURN_ON);
-	//delay_ms(100);
+	crc = CRC32_INITIAL;
 
-	#ifdef DEBUG_LEVEL_2
-		TRACE("burn_hex_auto(void)\n");
-	#endif
-	
-	// can read I2C or not
-	if(i2c_read_byte(SLAVEID_SPI, R_VERSION, &reg_temp) != 0){
-		#ifdef DEBUG_LEVEL_2
-			TRACE("I2C can't be read, auto-flash FAIL!!!\n");
-		#endif
-		chicago_power_onoff(0);
-		return -1;
-	}
-	
-	// read current OCM version
-	i2c_read_byte(SLAVEID_SPI, OCM_VERSION_MAJOR, &reg_temp);
-	current_version[0] = (reg_temp >> 4)&0x0F;
-	current_version[1] = (reg_temp)&0x0F;
-	i2c_read_byte(SLAVEID_SPI, OCM_BUILD_NUM, &reg_temp);
-	current_version[2] = reg_temp;
-
-	read_hex_ver(&hex_version[0]);
-
-	#ifdef DEBUG_LEVEL_2	
-		TRACE6("\tCurrent OCM version:%01x.%01x.%02x, HEX version:%01x.%01x.%02x\n",\
-				current_version[0],current_version[1],current_version[2],\
-				hex_version[0],hex_version[1],hex_version[2]);
-	#endif
-	
-	update_flag = 0;
-	
-	// check version
-	for(i=0; i<3; i++){
-		if(current_version[i] != hex_version[i]){
-			if(current_version[i] > hex_version[i]){
-				update_flag = 0;
-				break;
-			}
-			else{ // current < hex
-				update_flag = 1;
+	while(size_to_be_read != 0){
+		frame_address = Address;
+		frame_length = 0;
+
+		// fill one frame, 32 bytes per burst read
+		while((frame_length < FLASH_DUMP_FRAME_DATA_SIZE) && (size_to_be_read != 0)){
+			if(flash_read_block(Address, &FrameBuf[frame_length]) != RETURN_NORMAL_VALUE){
+				size_to_be_read = 0;  // host sees a short END frame
 				break;
 			}
+
+			chunk = (size_to_be_read > FLASH_READ_MAX_LENGTH) ? FLASH_READ_MAX_LENGTH : size_to_be_read;
+			frame_length	+= chunk;
+			Address			+= chunk;
+			size_to_be_read	-= chunk;
+		}
+
+		if(frame_length != 0){
+			crc = crc32_update(crc, &FrameBuf[0], frame_length);
+			flash_dump_frame(FLASH_DUMP_TYPE_DATA, frame_address, &FrameBuf[0], frame_length);
 		}
 	}
 
+	FrameBuf[0] = (uint8_t)(crc);
+	FrameBuf[1] = (uint8_t)(crc >> 8);
+	FrameBuf[2] = (uint8_t)(crc >> 16);
+	FrameBuf[3] = (uint8_t)(crc >> 24);
+	flash_dump_frame(FLASH_DUMP_TYPE_END, Address, &FrameBuf[0], 4);
 
-	if(update_flag == 0){	
-		#ifdef DEBUG_LEVEL_2
-			TRACE("\tCurrent version is the same or later then HEX version, no need to flash\n");
-		#endif
-		//chicago_power_onoff(0);
-		return 1;
-	}
+	TRACE("\n");
+
+	// restore register value
+	i2c_write_byte(SLAVEID_DP_IP, ADDR_HDCP2_CTRL, RegBak1);
+	i2c_write_byte(SLAVEID_SPI, OCM_DEBUG_CTRL, RegBak2);
+}
 
+//-----------------------------------------------------------------------------
+void burn_hex_prepare(void){
 	
-	// Erase OCM first
-	command_erase_partition(MAIN_OCM);
+	flash_timing_reset();
 
-	// prepare Flash
-	g_bFlashWrite = 1;
+	TRACE("You may send the HEX file now. SecureCRT -> Transfer -> Send ASCII ...\n");
+	g_bFlashWrite = FLASH_WRITE_PROGRAM;
 
 	#ifdef FALSH_READ_BACK
 		g_bFlashResult = 0;
 	#endif
 
     g_FlashRWinfo.total_bytes_written = 0;
-    g_FlashRWinfo.prog_is_Ping = 1;
-    flash_write_protection_disable();
 
-    delay_ms(1000);
-	
-	hex_index = 0;
-	hex_lines = (get_hex_size())/HEX_LINE_SIZE;
-	
-	TRACE("start to flash");
-	
-	// stop secure OCM to avoid buffer access conflict
-	i2c_read_byte(SLAVEID_DP_IP, ADDR_HDCP2_CTRL, &RegVal);
-	RegBak1 = RegVal;
-	RegVal &= (~HDCP2_FW_EN);
-	i2c_write_byte(SLAVEID_DP_IP, ADDR_HDCP2_CTRL, RegVal);
+	// \burnhex has erased the partitions already
+	flash_engine_begin(&g_FlashEngine, FLASH_ENGINE_VERIFY, NULL);
+
+	// the HEX file is streamed, its size is only known if it was staged
+	if (g_FlashStage.state == FLASH_STAGE_VALID){
+		TRACE2("Send the same file again: %lu bytes, CRC32 %08lX\n", g_FlashStage.staged_bytes, g_FlashStage.staged_crc);
+		g_FlashStage.state = FLASH_STAGE_PROGRAMMING;
+		g_FlashStage.lines = 0;
+		g_FlashStage.bytes = 0;
+		g_FlashStage.crc = CRC32_INITIAL;
+		flash_progress_begin(FLASH_PHASE_PROGRAM, g_FlashStage.staged_bytes);
+	}
+	else{
+		g_FlashStage.state = FLASH_STAGE_NONE;
+		flash_progress_begin(FLASH_PHASE_PROGRAM, 0);
+	}
 
-	// stop main OCM to avoid buffer access conflict
-	i2c_read_byte(SLAVEID_SPI, OCM_DEBUG_CTRL, &RegVal);
-	RegBak2 = RegVal;
-	RegVal |= OCM_RESET;
-	i2c_write_byte(SLAVEID_SPI, OCM_DEBUG_CTRL, RegVal);  
+    TRACE("Please make sure line send delay (SecureCRT -> Options -> Session Options -> Terminal\n");
+    TRACE("-> Emulation -> Advanced -> Line Send Delay) is set to enough long (Chicago: at least 5ms for 1MHz I2C)\n");
+    TRACE("before you select HEX file and transfer it.\n");
+}
 
-	flash_wait_until_flash_SM_done();
+//-----------------------------------------------------------------------------
+void burn_hex_stage_prepare(uint8_t Parts){
 
-	i2c_write_byte(SLAVEID_SPI, R_FLASH_LEN_H, (FLASH_WRITE_MAX_LENGTH - 1) >> 8);
-	i2c_write_byte(SLAVEID_SPI, R_FLASH_LEN_L, (FLASH_WRITE_MAX_LENGTH - 1) & 0xFF);
+	memset(&g_FlashStage, 0, sizeof(g_FlashStage));
+	g_FlashStage.state = FLASH_STAGE_CHECKING;
+	g_FlashStage.parts = Parts;
+	g_FlashStage.crc = CRC32_INITIAL;
 
-	do {
-		if((hex_index % 32) == 0){
-			TRACE("\n");
-		}
-		TRACE(".");
-		
-		memcpy(&WriteDataBuf[0],&OCM_FW_DATA[hex_index*HEX_LINE_SIZE],HEX_LINE_SIZE);
-		if(hex_index==hex_lines){
-			RecordType = HEX_RECORD_TYPE_EOF;
-			ByteCount = 0;
-		}else{
-			RecordType = HEX_RECORD_TYPE_DATA;
-			ByteCount = HEX_LINE_SIZE;
-			
-			if(hex_index==(hex_lines-1)){
-				Address = MAIN_OCM_FW_ADDR_END-HEX_LINE_SIZE+1;
-			}else{
-				Address = MAIN_OCM_FW_ADDR_BASE+(hex_index*HEX_LINE_SIZE);
-			}
-		}
-		
-		/* ================================ Ping: accumulates data ================================ */
-		if (g_FlashRWinfo.prog_is_Ping){
-	
-			/* end of HEX file */
-			if (RecordType == HEX_RECORD_TYPE_EOF){
-				g_bFlashWrite = 0;
-			
-				// check read back flag
-				if(1==g_bFlashResult){
-					TRACE("\nFlash ERROR!!! read back data was not the same as write data\n");
-					TRACE("Please burn again.\n\n");
-				}else{
-					TRACE1("\n[Ping] Flash program done. %lu bytes written.\n\n", g_FlashRWinfo.total_bytes_written);
-				}
+	g_bFlashWrite = FLASH_WRITE_STAGE;
 
-				// TODO: start a timer to check how much time it takes to program the Flash
-				flash_HW_write_protection_enable();
-				break;
-			}
+	TRACE("Staged burn: send the HEX file now, it is only checked, nothing is erased yet.\n");
+	TRACE("If it checks out, the partitions are erased and you send the same file again.\n");
+}
 
-		auto_write_prepare_in_ping:
-			flash_write_prepare(Address, (uint8_t)0, ByteCount, &WriteDataBuf[0]);
+//-----------------------------------------------------------------------------
+uint8_t burn_hex_stage_ready(void){
+	return (g_FlashStage.state == FLASH_STAGE_VALID) ? g_FlashStage.parts : 0;
+}
 
-			read_Address = Address;
-			flash_writedata_keep(&WriteDataBuf[0], &ReadDataBuf[0], ByteCount);
-			read_ByteCount = ByteCount;
+//-----------------------------------------------------------------------------
+uint8_t burn_hex_auto(void){
+	tagBurnHexAuto Task;
+
+	burn_hex_auto_begin(&Task);
+	while(burn_hex_auto_step(&Task) < BURN_AUTO_DONE){
+		// the step leaves its delays to the caller
+		if(Task.wait_us != 0){
+			flash_sleep_us(Task.wait_us);
+		}
+	}
 
-			g_FlashRWinfo.previous_addr = Address;
+	return (uint8_t)Task.result;
+}
 
-			g_FlashRWinfo.bytes_accumulated_in_Ping = ByteCount;
-			g_FlashRWinfo.prog_is_Ping = 0;
+//-----------------------------------------------------------------------------
+void burn_hex_auto_begin(tagBurnHexAuto *pTask){
+	pTask->state		= BURN_AUTO_START;
+	pTask->result		= RETURN_FAILURE_VALUE;
+	pTask->update_parts	= 0;
+	pTask->check_parts	= 0;
+	pTask->retries		= 0;
+	pTask->crc_bits		= 0;
+	pTask->wait_us		= 0;
+}
 
-			if ( (Address % FLASH_WRITE_MAX_LENGTH) != 0 ) // We're now in ping, but we have to do something that is normally done in pong (the Address dictates this),
-			{                                              // so that we can recover the ping-pong cadence.
+//-----------------------------------------------------------------------------
+uint8_t burn_hex_auto_step(tagBurnHexAuto *pTask){
+	uint8_t reg_temp;
+	uint8_t load_status;
+	uint8_t part_id;
+	uint32_t bundle_crc;
+	uint32_t base;
+	uint32_t end;
+	uint32_t chunk;
+	uint32_t elapsed;
+	int8_t return_code;
+	const tagOcmPartitionInfo *pPart;
+	tagFlashRecord Record;
+
+	if(pTask->wait_us != 0){
+		if((TIMESTAMP_US() - pTask->wait_start_us) < pTask->wait_us){
+			return pTask->state;
+		}
+		pTask->wait_us = 0;
+	}
 
-				for (i=0; i<MAX_BYTE_COUNT_PER_RECORD_FLASH; i++){
-					i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_0 + i, 0xFF);
-				}
-				
-				flash_write_prepare(Address - MAX_BYTE_COUNT_PER_RECORD_FLASH, (uint8_t)MAX_BYTE_COUNT_PER_RECORD_FLASH, ByteCount, &WriteDataBuf[0]);
-				flash_actual_write();
+	switch(pTask->state){
 
-				g_FlashRWinfo.total_bytes_written += ByteCount;
-				g_FlashRWinfo.bytes_accumulated_in_Ping = 0;
-				g_FlashRWinfo.prog_is_Ping = 1;
-				g_FlashRWinfo.previous_addr = Address;
+	case BURN_AUTO_START:
+		// RESET chicago first
+		chicago_power_onoff(CHICAGO_TURN_ON);
+
+		#ifdef DEBUG_LEVEL_2
+			TRACE("burn_hex_auto(void)\n");
+		#endif
+
+		// can read I2C or not
+		if(i2c_read_byte(SLAVEID_SPI, R_VERSION, &reg_temp) != 0){
+			#ifdef DEBUG_LEVEL_2
+				TRACE("I2C can't be read, auto-flash FAIL!!!\n");
+			#endif
+			chicago_power_onoff(0);
+			pTask->state = BURN_AUTO_FAILED;
+			break;
+		}
+
+		// leave the decision to the version and flash CRC checks if this can't be read
+		if(i2c_read_byte(SLAVEID_SPI, HDCP_LOAD_STATUS, &load_status) != RETURN_NORMAL_VALUE){
+			load_status = 0xFF;
+		}
+
+		bundle_crc = CRC32_INITIAL;
+
+		for(part_id = 0; part_id < PARTITION_ID_MAX; part_id++){
+			pPart = ocm_image_partition(part_id);
+			if(pPart == NULL){
+				continue;
+			}
+
+			bundle_crc = crc32_update(bundle_crc, (const uint8_t *)&pPart->crc32, sizeof(pPart->crc32));
+
+			if(burn_hex_auto_needed(pPart, load_status)){
+				pTask->update_parts |= (1 << part_id);
+			}
+			else if(part_id != MAIN_OCM){
+				// no version register for secure OCM or the keys, compare what is in flash
+				pTask->check_parts |= (1 << part_id);
+			}
+		}
+
+		// a half-written partition reports whatever version it likes, trust the journal instead
+		flash_journal_open(&pTask->journal, bundle_crc);
+		if(flash_journal_in_progress(&pTask->journal)){
+			#ifdef DEBUG_LEVEL_2
+				TRACE("\tPrevious update of this HEX was interrupted, resuming\n");
+			#endif
+			for(part_id = 0; part_id < PARTITION_ID_MAX; part_id++){
+				if(ocm_image_partition(part_id) != NULL){
+					pTask->update_parts |= (1 << part_id);
+				}
+			}
+			pTask->check_parts = 0;
+		}
+
+		if(pTask->check_parts != 0){
+			flash_progress_begin(FLASH_PHASE_CHECK, burn_hex_auto_bytes(pTask->check_parts, 0));
+		}
+
+		pTask->state = burn_hex_auto_check_part(pTask, 0);
+		break;
+
+	case BURN_AUTO_CHECK:
+		pPart = ocm_image_partition(pTask->part_id);
+		flash_partition_bounds(pTask->part_id, &base, &end);
+
+		chunk = base + pPart->size - pTask->crc_addr;
+		if(chunk > BURN_AUTO_CHECK_CHUNK){
+			chunk = BURN_AUTO_CHECK_CHUNK;
+		}
+
+		if((pPart->size > end - base + 1) ||
+		   (flash_partition_crc32(pTask->crc_addr, chunk, &pTask->crc) != RETURN_NORMAL_VALUE)){
+			pTask->crc_addr = base + pPart->size;
+			pTask->crc = ~pPart->crc32;
+		}
+		else{
+			pTask->crc_addr += chunk;
+			flash_progress_add(chunk);
+		}
+
+		if(pTask->crc_addr < base + pPart->size){
+			break;
+		}
+
+		if(pTask->crc != pPart->crc32){
+			#ifdef DEBUG_LEVEL_2
+				TRACE1("\tPartition %d differs from the embedded image\n", pTask->part_id);
+			#endif
+			pTask->update_parts |= (1 << pTask->part_id);
+		}
+
+		pTask->state = burn_hex_auto_check_part(pTask, pTask->part_id + 1);
+		break;
+
+	case BURN_AUTO_DECIDE:
+		if(pTask->update_parts == 0){
+			#ifdef DEBUG_LEVEL_2
+				TRACE("\tCurrent version is the same or later then HEX version, no need to flash\n");
+			#endif
+			//chicago_power_onoff(0);
+			pTask->result = 1;
+			pTask->state = BURN_AUTO_UP_TO_DATE;
+			break;
+		}
+
+		// don't touch the flash unless the embedded image unpacks to what the packer saw
+		return_code = ocm_image_check();
+		for(part_id = 0; part_id < PARTITION_ID_MAX; part_id++){
+			if((pTask->update_parts & (1 << part_id)) && (flash_source_ocm_image_open(&pTask->source, part_id) != RETURN_NORMAL_VALUE)){
+				return_code = RETURN_FAILURE_VALUE;
+			}
+			if(pTask->update_parts & (1 << part_id)){
+				// verified in flash is not the same as accepted by the boot loader
+				pTask->crc_bits |= g_PartitionCrcBits[part_id];
+			}
+		}
+
+		if(return_code != RETURN_NORMAL_VALUE){
+			#ifdef DEBUG_LEVEL_2
+				TRACE("\tEmbedded OCM image is corrupt, auto-flash FAIL!!!\n");
+			#endif
+			pTask->state = BURN_AUTO_FAILED;
+			break;
+		}
+
+		#ifdef FALSH_READ_BACK
+			g_bFlashResult = 0;
+		#endif
+
+		flash_timing_reset();
+
+		g_FlashRWinfo.total_bytes_written = 0;
+
+		TRACE1("start to flash, partition mask 0x%02X\n", pTask->update_parts);
+
+		// the source pads every partition out to its end
+		flash_progress_begin(FLASH_PHASE_PROGRAM, burn_hex_auto_bytes(pTask->update_parts, 1));
+
+		flash_engine_begin(&pTask->engine, FLASH_ENGINE_ERASE | FLASH_ENGINE_VERIFY | FLASH_ENGINE_ASYNC, &pTask->journal);
+		pTask->state = burn_hex_auto_open_part(pTask, 0);
+		break;
+
+	case BURN_AUTO_PROGRAM:
+		// let the sector erase run while the application does its thing
+		return_code = flash_engine_poll(&pTask->engine);
+		if(return_code == FLASH_ENGINE_BUSY){
+			// nothing to see before the typical time, keep off the bus
+			elapsed = TIMESTAMP_US() - pTask->engine.erase_start_us;
+			pTask->wait_start_us = TIMESTAMP_US();
+			pTask->wait_us = (elapsed < FLASH_TIME_SECTOR_ERASE_TYP) ? (FLASH_TIME_SECTOR_ERASE_TYP - elapsed) : BURN_AUTO_ERASE_POLL_US;
+			break;
+		}
+
+		if(return_code == RETURN_NORMAL_VALUE){
+			return_code = flash_source_ocm_image(&pTask->source, &Record);
+			if(return_code == 0){
+				pTask->state = burn_hex_auto_open_part(pTask, pTask->part_id + 1);
+				break;
+			}
+			return_code = flash_engine_write(&pTask->engine, Record.address, &Record.data[0], Record.length);
+		}
+
+		if(return_code != RETURN_NORMAL_VALUE){
+			pTask->state = BURN_AUTO_FINISH;
+		}
+		break;
+
+	case BURN_AUTO_FINISH:
+		return_code = flash_engine_end(&pTask->engine);
+
+		// a sector the journal called verified but isn't is now marked untouched, so go again
+		if((return_code == FLASH_ENGINE_ERR_RESUME) && (++pTask->retries < FLASH_ENGINE_RESUME_RETRIES)){
+			flash_progress_begin(FLASH_PHASE_PROGRAM, burn_hex_auto_bytes(pTask->update_parts, 1));
+			flash_engine_begin(&pTask->engine, FLASH_ENGINE_ERASE | FLASH_ENGINE_VERIFY | FLASH_ENGINE_ASYNC, &pTask->journal);
+			pTask->state = burn_hex_auto_open_part(pTask, 0);
+			break;
+		}
+
+		if(return_code != RETURN_NORMAL_VALUE){
+			TRACE1("\nFlash ERROR!!! read back data was not the same as write data at sector 0x%04X\n", pTask->engine.sector_addr);
+			TRACE("The next update attempt resumes from this sector.\n\n");
+			pTask->state = BURN_AUTO_FAILED;
+			break;
+		}
+
+		flash_journal_close(&pTask->journal);
+		FLASH_TIMING_ADD(total_us, g_FlashTiming.start_us);
+		TRACE1("\nFlash program done. %lu bytes written.\n\n", g_FlashRWinfo.total_bytes_written);
+
+		#ifdef DEBUG_LEVEL_2
+			flash_timing_report();
+		#endif
+
+		pTask->state = BURN_AUTO_POWER_OFF;
+		burn_hex_auto_wait(pTask, BURN_AUTO_POWER_DELAY_MS);
+		break;
+
+	case BURN_AUTO_POWER_OFF:
+		// RESET chicago after burn done
+		chicago_power_onoff(0);
+		pTask->state = BURN_AUTO_SUPPLY_OFF;
+		burn_hex_auto_wait(pTask, BURN_AUTO_POWER_DELAY_MS);
+		break;
+
+	case BURN_AUTO_SUPPLY_OFF:
+		chicago_power_supply(0);
+		pTask->state = BURN_AUTO_SUPPLY_ON;
+		burn_hex_auto_wait(pTask, BURN_AUTO_POWER_DELAY_MS);
+		break;
+
+	case BURN_AUTO_SUPPLY_ON:
+		chicago_power_supply(1);
+		chicago_power_onoff(CHICAGO_TURN_ON);
+		pTask->boot_start_us = TIMESTAMP_US();
+		pTask->state = BURN_AUTO_BOOT_CHECK;
+		flash_progress_begin(FLASH_PHASE_BOOT, 0);
+		break;
+
+	case BURN_AUTO_BOOT_CHECK:
+		if((i2c_read_byte(SLAVEID_SPI, HDCP_LOAD_STATUS, &reg_temp) == RETURN_NORMAL_VALUE) &&
+		   ((reg_temp & pTask->crc_bits) == pTask->crc_bits)){
+			pTask->result = RETURN_NORMAL_VALUE;
+		}
+		else if((TIMESTAMP_US() - pTask->boot_start_us) < (uint32_t)FLASH_BOOT_CHECK_TIMEOUT_MS * 1000){
+			burn_hex_auto_wait(pTask, FLASH_BOOT_CHECK_INTERVAL_MS);
+			break;
+		}
+		else{
+			TRACE("Flash ERROR!!! Chicago rejected the new image at boot (HDCP_LOAD_STATUS CRC check)\n");
+		}
+
+		#ifdef DEBUG_LEVEL_2
+			TRACE2("\tHDCP_LOAD_STATUS 0x%02X after %lu ms\n", reg_temp, (TIMESTAMP_US() - pTask->boot_start_us) / 1000);
+		#endif
+
+		// the main loop powers Chicago up again when a cable is plugged in
+		chicago_power_onoff(0);
+		pTask->state = (pTask->result == RETURN_NORMAL_VALUE) ? BURN_AUTO_DONE : BURN_AUTO_FAILED;
+		break;
+
+	default:
+		break;
+	}
+
+	return pTask->state;
+}
+
+//-----------------------------------------------------------------------------
+void flash_engine_begin(tagFlashEngine *pEngine, uint8_t Flags, tagFlashJournal *pJournal){
+	uint32_t timestamp;
+
+	pEngine->flags				= Flags;
+	pEngine->status				= RETURN_NORMAL_VALUE;
+	pEngine->pJournal			= pJournal;
+	pEngine->sector_addr		= FLASH_ENGINE_NONE;
+	pEngine->sector_mode		= FLASH_ENGINE_SECTOR_PROGRAM;
+	pEngine->sector_ok			= 1;
+	pEngine->sectors_visited	= 0;
+	pEngine->sectors_erased		= 0;
+	pEngine->block_addr			= FLASH_ENGINE_NONE;
+	pEngine->block_mask			= 0;
+	pEngine->erase_pending		= 0;
+
+	flash_write_protection_disable();
+
+	timestamp = TIMESTAMP_US();
+	flash_ocm_stop(&pEngine->RegBak1, &pEngine->RegBak2);
+	FLASH_TIMING_ADD(ocm_stop_us, timestamp);
+
+	i2c_write_byte(SLAVEID_SPI, R_FLASH_LEN_H, (FLASH_WRITE_MAX_LENGTH - 1) >> 8);
+	i2c_write_byte(SLAVEID_SPI, R_FLASH_LEN_L, (FLASH_WRITE_MAX_LENGTH - 1) & 0xFF);
+}
+
+//-----------------------------------------------------------------------------
+int8_t flash_engine_write(tagFlashEngine *pEngine, uint32_t Address, const uint8_t *pData, uint16_t Length){
+	uint32_t block_addr;
+	uint32_t sector_addr;
+	uint8_t  offset;
+	uint8_t  n;
+	int8_t   return_code;
+
+	while(Length != 0){
+		block_addr = Address & ~((uint32_t)FLASH_WRITE_MAX_LENGTH - 1);
+
+		if(block_addr != pEngine->block_addr){
+			return_code = flash_engine_flush(pEngine);
+			if(return_code != RETURN_NORMAL_VALUE){
+				return return_code;
+			}
+
+			sector_addr = block_addr & ~((uint32_t)FLASH_SECTOR_SIZE - 1);
+			if(sector_addr != pEngine->sector_addr){
+				flash_engine_leave_sector(pEngine);
+				return_code = flash_engine_enter_sector(pEngine, sector_addr);
+				if(return_code != RETURN_NORMAL_VALUE){
+					return return_code;
+				}
+			}
+
+			pEngine->block_addr = block_addr;
+			pEngine->block_mask = 0;
+			memset(&pEngine->block[0], 0xFF, FLASH_WRITE_MAX_LENGTH);
+		}
+
+		offset = (uint8_t)(Address - block_addr);
+		n = FLASH_WRITE_MAX_LENGTH - offset;
+		if(n > Length){
+			n = (uint8_t)Length;
+		}
+
+		memcpy(&pEngine->block[offset], pData, n);
+		pEngine->block_mask |= ((n == FLASH_WRITE_MAX_LENGTH) ? 0xFFFFFFFFUL : ((((uint32_t)1 << n) - 1) << offset));
+
+		Address += n;
+		pData += n;
+		Length -= n;
+	}
+
+	return RETURN_NORMAL_VALUE;
+}
+
+//-----------------------------------------------------------------------------
+int8_t flash_engine_run(tagFlashEngine *pEngine, tagFlashSource *pSource){
+	tagFlashRecord Record;
+	int8_t return_code;
+
+	while((return_code = pSource->next(pSource->pContext, &Record)) > 0){
+		return_code = flash_engine_write(pEngine, Record.address, &Record.data[0], Record.length);
+		if(return_code != RETURN_NORMAL_VALUE){
+			return return_code;
+		}
+	}
+
+	return return_code;
+}
+
+//-----------------------------------------------------------------------------
+int8_t flash_engine_end(tagFlashEngine *pEngine){
+
+	flash_engine_flush(pEngine);
+	flash_engine_leave_sector(pEngine);
+
+	flash_HW_write_protection_enable();
+	flash_ocm_restore(pEngine->RegBak1, pEngine->RegBak2);
+
+	return pEngine->status;
+}
+
+//-----------------------------------------------------------------------------
+int8_t flash_engine_poll(tagFlashEngine *pEngine){
+	return flash_engine_erase_done(pEngine, 0);
+}
+
+//-----------------------------------------------------------------------------
+int8_t flash_source_ocm_image(void *pContext, tagFlashRecord *pRecord){
+	tagOcmImageSource *pSource = (tagOcmImageSource *)pContext;
+	uint32_t offset;
+
+	if(pSource->address > pSource->end){
+		return 0;
+	}
+
+	pRecord->address = pSource->address;
+	pRecord->length = HEX_LINE_SIZE;
+
+	if(pSource->part_id == MAIN_OCM){
+		offset = burn_hex_auto_offset(pSource->hex_lines, pSource->address);
+	}
+	else{
+		offset = pSource->address - pSource->base;
+		if(offset >= pSource->stream.image_size){
+			offset = HEX_OFFSET_NONE;
+		}
+	}
+
+	if(offset == HEX_OFFSET_NONE){
+		memset(&pRecord->data[0], 0xFF, HEX_LINE_SIZE);
+	}
+	else{
+		if(offset > pSource->stream.out_index){
+			ocm_image_skip(&pSource->stream, offset - pSource->stream.out_index);
+		}
+		ocm_image_read(&pSource->stream, &pRecord->data[0], HEX_LINE_SIZE);
+	}
+
+	pSource->address += HEX_LINE_SIZE;
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+int8_t flash_source_ocm_image_open(tagOcmImageSource *pSource, uint8_t PartId){
+
+	if((flash_partition_bounds(PartId, &pSource->base, &pSource->end) != RETURN_NORMAL_VALUE) ||
+	   (ocm_image_open_partition(&pSource->stream, PartId) != RETURN_NORMAL_VALUE)){
+		return RETURN_FAILURE_VALUE;
+	}
+
+	pSource->part_id	= PartId;
+	pSource->address	= pSource->base;
+	pSource->hex_lines	= pSource->stream.image_size / HEX_LINE_SIZE;
+
+	// burn_hex_auto_offset() folds MAIN_OCM into place, the others must fit as they are
+	if(PartId == MAIN_OCM){
+		return (pSource->hex_lines != 0) ? RETURN_NORMAL_VALUE : RETURN_FAILURE_VALUE;
+	}
+
+	return (pSource->stream.image_size <= pSource->end - pSource->base + 1) ? RETURN_NORMAL_VALUE : RETURN_FAILURE_VALUE;
+}
+
+//-----------------------------------------------------------------------------
+void flash_timing_reset(void){
+	memset(&g_FlashTiming, 0, sizeof(g_FlashTiming));
+	g_FlashTiming.start_us = TIMESTAMP_US();
+}
+
+//-----------------------------------------------------------------------------
+void flash_progress_set(FlashProgress_t Callback, void *pContext, uint32_t Granularity){
+	g_FlashProgress.callback	= Callback;
+	g_FlashProgress.pContext	= pContext;
+	g_FlashProgress.granularity	= (Granularity != 0) ? Granularity : FLASH_PROGRESS_GRANULARITY;
+}
+
+//-----------------------------------------------------------------------------
+void flash_progress_begin(uint8_t Phase, uint32_t Total){
+	g_FlashProgress.start_us			= TIMESTAMP_US();
+	g_FlashProgress.last_us				= g_FlashProgress.start_us;
+	g_FlashProgress.last_bytes			= 0;
+	g_FlashProgress.report.phase		= Phase;
+	g_FlashProgress.report.bytes_done	= 0;
+	g_FlashProgress.report.bytes_total	= Total;
+
+	flash_progress_report();
+}
+
+//-----------------------------------------------------------------------------
+void flash_progress_add(uint32_t Bytes){
+	tagFlashProgress *pReport = &g_FlashProgress.report;
+
+	pReport->bytes_done += Bytes;
+
+	if(g_FlashProgress.callback == NULL){
+		return;
+	}
+
+	// every granularity bytes, and once more on reaching the total
+	if((pReport->bytes_done - g_FlashProgress.last_bytes >= g_FlashProgress.granularity) ||
+	   ((pReport->bytes_total != 0) && (pReport->bytes_done >= pReport->bytes_total) &&
+		(g_FlashProgress.last_bytes < pReport->bytes_total))){
+		flash_progress_report();
+	}
+}
+
+//-----------------------------------------------------------------------------
+void flash_timing_report(void){
+	TRACE1("\tFlash timing (us), total %lu\n", g_FlashTiming.total_us);
+	TRACE2("\t  OCM stop     %10lu    WP disable %10lu\n", g_FlashTiming.ocm_stop_us, g_FlashTiming.wp_disable_us);
+	TRACE2("\t  erase        %10lu    WP enable  %10lu\n", g_FlashTiming.erase_us, g_FlashTiming.wp_enable_us);
+	TRACE2("\t  staging      %10lu    program    %10lu\n", g_FlashTiming.staging_us, g_FlashTiming.program_us);
+	TRACE1("\t  verify       %10lu\n", g_FlashTiming.verify_us);
+	TRACE2("\t  of which WIP %10lu in %lu polls\n", g_FlashTiming.wip_wait_us, g_FlashTiming.wip_polls);
+	TRACE2("\t  of which SM  %10lu in %lu polls\n", g_FlashTiming.sm_wait_us, g_FlashTiming.sm_polls);
+	if(g_FlashTiming.timeouts != 0){
+		TRACE1("\t  %lu waits timed out\n", g_FlashTiming.timeouts);
+	}
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc flash_wait_until_WIP_cleared
+static int8_t flash_wait_until_WIP_cleared(uint8_t Operation){
+	uint8_t  tmp;
+	uint32_t timestamp;
+	uint32_t interval;
+	uint32_t elapsed;
+	
+	timestamp = TIMESTAMP_US();
+
+	// nothing to see before the typical time, keep off the bus
+	if(g_FlashOpTime[Operation].typ_us != 0){
+		flash_sleep_us(g_FlashOpTime[Operation].typ_us);
+	}
+
+	interval = g_FlashOpTime[Operation].typ_us / 8;
+	if(interval < FLASH_POLL_INTERVAL_MIN){
+		interval = FLASH_POLL_INTERVAL_MIN;
+	}
+
+	while(1){
+		read_status_enable();
+		
+		// read STATUS_REGISTER
+		i2c_read_byte(SLAVEID_SPI, R_FLASH_STATUS_4, &tmp);
+		g_FlashTiming.wip_polls++;
+
+		if((tmp & 1) == 0){
+			break;
+		}
+
+		elapsed = TIMESTAMP_US() - timestamp;
+		if(elapsed >= g_FlashOpTime[Operation].max_us){
+			g_FlashTiming.timeouts++;
+			FLASH_TIMING_ADD(wip_wait_us, timestamp);
+			return RETURN_FAILURE_VALUE;
+		}
+
+		flash_sleep_us(interval);
+		if(interval < FLASH_POLL_INTERVAL_MAX){
+			interval *= 2;
+		}
+	}
+
+	FLASH_TIMING_ADD(wip_wait_us, timestamp);
+	return RETURN_NORMAL_VALUE;
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc flash_wait_until_flash_SM_done
+static int8_t flash_wait_until_flash_SM_done(void){
+	uint8_t  tmp;
+	uint32_t timestamp;
+	uint32_t interval;
+	
+	timestamp = TIMESTAMP_US();
+	interval = FLASH_POLL_INTERVAL_MIN;
+
+	while(1){
+		i2c_read_byte(SLAVEID_SPI, R_RAM_CTRL, &tmp);
+		g_FlashTiming.sm_polls++;
+
+		if((tmp & FLASH_DONE) != 0){
+			break;
+		}
+
+		if((TIMESTAMP_US() - timestamp) >= FLASH_TIME_SM_MAX){
+			g_FlashTiming.timeouts++;
+			FLASH_TIMING_ADD(sm_wait_us, timestamp);
+			return RETURN_FAILURE_VALUE;
+		}
+
+		flash_sleep_us(interval);
+		if(interval < FLASH_POLL_INTERVAL_MAX){
+			interval *= 2;
+		}
+	}
+
+	FLASH_TIMING_ADD(sm_wait_us, timestamp);
+	return RETURN_NORMAL_VALUE;
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc flash_sleep_us
+static void flash_sleep_us(uint32_t Microseconds){
+	// delay() yields to the rest of the sketch, delayMicroseconds() spins
+	if(Microseconds >= 1000){
+		delay_ms(Microseconds / 1000);
+		Microseconds %= 1000;
+	}
+
+	if(Microseconds != 0){
+		DELAY_US(Microseconds);
+	}
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc flash_erase_sector
+static int8_t flash_erase_sector(uint32_t Address){
+	uint32_t timestamp;
+	int8_t return_code = RETURN_NORMAL_VALUE;
+
+	timestamp = TIMESTAMP_US();
+	flash_sector_erase(Address);
+
+	#ifndef  DRY_RUN
+		return_code = flash_wait_until_WIP_cleared(FLASH_OP_SECTOR_ERASE);
+	#endif
+
+	if(flash_wait_until_flash_SM_done() != RETURN_NORMAL_VALUE){
+		return_code = RETURN_FAILURE_VALUE;
+	}
+	FLASH_TIMING_ADD(erase_us, timestamp);
+
+	return return_code;
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc flash_read_block
+static int8_t flash_read_block(uint32_t Address, uint8_t *pData){
+
+	i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_H, Address >> 8);
+	i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_L, Address & 0xFF);
+	i2c_write_byte(SLAVEID_SPI, R_FLASH_LEN_H, 0);
+	i2c_write_byte(SLAVEID_SPI, R_FLASH_LEN_L, FLASH_READ_MAX_LENGTH - 1);  // Reads 32 bytes
+
+	ocm_read_enable();
+	if(flash_wait_until_flash_SM_done() != RETURN_NORMAL_VALUE){
+		return RETURN_FAILURE_VALUE;
+	}
+
+	// FLASH_READ_D0.. auto-increments, one transaction instead of 32
+	return i2c_read_block(SLAVEID_SPI, FLASH_READ_D0, pData, FLASH_READ_MAX_LENGTH);
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc flash_dump_frame
+static void flash_dump_frame(uint8_t Type, uint32_t Address, uint8_t *pData, uint16_t Length){
+	uint8_t header[FLASH_DUMP_HEADER_SIZE];
+	uint8_t trailer[4];
+	uint32_t crc;
+
+	header[0] = FLASH_DUMP_SYNC0;
+	header[1] = FLASH_DUMP_SYNC1;
+	header[2] = Type;
+	header[3] = (uint8_t)(Address);
+	header[4] = (uint8_t)(Address >> 8);
+	header[5] = (uint8_t)(Address >> 16);
+	header[6] = (uint8_t)(Address >> 24);
+	header[7] = (uint8_t)(Length);
+	header[8] = (uint8_t)(Length >> 8);
+
+	crc = crc32_update(CRC32_INITIAL, &header[2], FLASH_DUMP_HEADER_SIZE - 2);
+	crc = crc32_update(crc, pData, Length);
+
+	trailer[0] = (uint8_t)(crc);
+	trailer[1] = (uint8_t)(crc >> 8);
+	trailer[2] = (uint8_t)(crc >> 16);
+	trailer[3] = (uint8_t)(crc >> 24);
+
+	TRACE_BIN(&header[0], FLASH_DUMP_HEADER_SIZE);
+	TRACE_BIN(pData, Length);
+	TRACE_BIN(&trailer[0], 4);
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc burn_hex_auto_offset
+static uint32_t burn_hex_auto_offset(uint32_t hex_lines, uint32_t Address){
+	uint32_t line;
+
+	// the last line of the image always goes to the top of the partition
+	if(Address == (MAIN_OCM_FW_ADDR_END - HEX_LINE_SIZE + 1)){
+		return (hex_lines - 1) * HEX_LINE_SIZE;
+	}
+
+	line = (Address - MAIN_OCM_FW_ADDR_BASE) / HEX_LINE_SIZE;
+	if(line < (hex_lines - 1)){
+		return line * HEX_LINE_SIZE;
+	}
+
+	return HEX_OFFSET_NONE;
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc burn_hex_auto_needed
+static uint8_t burn_hex_auto_needed(const tagOcmPartitionInfo *pPart, uint8_t LoadStatus){
+	uint8_t reg_temp;
+	uint8_t current_version[3];
+	uint8_t i;
+
+	if((LoadStatus & g_PartitionCrcBits[pPart->id]) != g_PartitionCrcBits[pPart->id]){
+		#ifdef DEBUG_LEVEL_2
+			TRACE1("\tPartition %d failed its boot CRC check\n", pPart->id);
+		#endif
+		return 1;
+	}
+
+	if(pPart->id == MAIN_OCM){
+		// read current OCM version
+		i2c_read_byte(SLAVEID_SPI, OCM_VERSION_MAJOR, &reg_temp);
+		current_version[0] = (reg_temp >> 4)&0x0F;
+		current_version[1] = (reg_temp)&0x0F;
+		i2c_read_byte(SLAVEID_SPI, OCM_BUILD_NUM, &reg_temp);
+		current_version[2] = reg_temp;
+
+		#ifdef DEBUG_LEVEL_2	
+			TRACE6("\tCurrent OCM version:%01x.%01x.%02x, HEX version:%01x.%01x.%02x\n",\
+					current_version[0],current_version[1],current_version[2],\
+					pPart->version[0],pPart->version[1],pPart->version[2]);
+		#endif
+
+		for(i=0; i<3; i++){
+			if(current_version[i] != pPart->version[i]){
+				return (current_version[i] < pPart->version[i]) ? 1 : 0;
 			}
+		}
+
+		return 0;
+	}
+
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc burn_hex_auto_next_part
+static uint8_t burn_hex_auto_next_part(uint8_t Parts, uint8_t PartId){
+
+	while((PartId < PARTITION_ID_MAX) && !(Parts & (1 << PartId))){
+		PartId++;
+	}
+
+	return PartId;
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc burn_hex_auto_open_part
+static uint8_t burn_hex_auto_open_part(tagBurnHexAuto *pTask, uint8_t PartId){
+
+	pTask->part_id = burn_hex_auto_next_part(pTask->update_parts, PartId);
+	if(pTask->part_id == PARTITION_ID_MAX){
+		return BURN_AUTO_FINISH;
+	}
+
+	// BURN_AUTO_DECIDE already opened every one of them once
+	flash_source_ocm_image_open(&pTask->source, pTask->part_id);
+	return BURN_AUTO_PROGRAM;
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc burn_hex_auto_check_part
+static uint8_t burn_hex_auto_check_part(tagBurnHexAuto *pTask, uint8_t PartId){
+	uint32_t end;
+
+	pTask->part_id = burn_hex_auto_next_part(pTask->check_parts, PartId);
+	if(pTask->part_id == PARTITION_ID_MAX){
+		return BURN_AUTO_DECIDE;
+	}
+
+	flash_partition_bounds(pTask->part_id, &pTask->crc_addr, &end);
+	pTask->crc = CRC32_INITIAL;
+	return BURN_AUTO_CHECK;
+}
 
-			hex_index++;
+//-----------------------------------------------------------------------------
+/// @copydoc burn_hex_auto_bytes
+static uint32_t burn_hex_auto_bytes(uint8_t Parts, uint8_t Padded){
+	const tagOcmPartitionInfo *pPart;
+	uint32_t base;
+	uint32_t end;
+	uint32_t total;
+	uint8_t part_id;
+
+	total = 0;
+	for(part_id = 0; part_id < PARTITION_ID_MAX; part_id++){
+		pPart = ocm_image_partition(part_id);
+		if(!(Parts & (1 << part_id)) || (pPart == NULL) ||
+		   (flash_partition_bounds(part_id, &base, &end) != RETURN_NORMAL_VALUE)){
 			continue;
 		}
+		total += Padded ? (end - base + 1) : pPart->size;
+	}
 
-		/* ================================ Pong: program Flash ================================ */
-		/* note: GetLineData() can ONLY be called ONCE per flash_program() invoke, */
-		/* otherwise serial port buffer has no chance to be updated, and the same HEX record is used twice, */
-		/* which is incorrect. */
-		if (!g_FlashRWinfo.prog_is_Ping){
-			
-			/* end of HEX file */
-			if (RecordType == HEX_RECORD_TYPE_EOF){
-				
-				for (i=0; i<MAX_BYTE_COUNT_PER_RECORD_FLASH; i++){
-					i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_0 + MAX_BYTE_COUNT_PER_RECORD_FLASH + i, 0xFF);
-				}
-				
-				flash_actual_write();
-				g_FlashRWinfo.total_bytes_written += g_FlashRWinfo.bytes_accumulated_in_Ping;
-				g_bFlashWrite = 0;
-
-				if(g_bFlashResult == 1){
-					TRACE("\nFlash ERROR!!! read back data was not the same as write data\n");
-					TRACE("Please burn again.\n\n");
-				}else{
-					TRACE1("\n[Pong] Flash program done. %lu bytes written.\n", g_FlashRWinfo.total_bytes_written);
+	return total;
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc burn_hex_stage_line
+static void burn_hex_stage_line(void){
+	uint8_t DataBuf[CMD_LINE_SIZE / 2];  // GetLineData() doesn't stop at MAX_BYTE_COUNT_PER_RECORD_FLASH
+	uint8_t ByteCount;
+	uint32_t Address;
+	uint8_t RecordType;
+	int8_t  return_code;
+	uint8_t error;
+
+	// a command instead of HEX, the transfer never started or was cut short
+	if (g_CmdLineBuf[0] == '\\'){
+		TRACE("HEX staging abandoned, nothing was erased.\n");
+		g_FlashStage.state = FLASH_STAGE_NONE;
+		g_bFlashWrite = FLASH_WRITE_OFF;
+		return;
+	}
+
+	g_FlashStage.lines++;
+
+	return_code = GetLineData(g_CmdLineBuf, &ByteCount, &Address, &RecordType, &DataBuf[0]);
+
+	error = FLASH_STAGE_OK;
+	if (return_code != RETURN_NORMAL_VALUE){
+		error = FLASH_STAGE_BAD_LINE;
+	}
+	else if (RecordType == HEX_RECORD_TYPE_EOF){
+		g_bFlashWrite = FLASH_WRITE_OFF;
+
+		if ((g_FlashStage.error == FLASH_STAGE_OK) && (g_FlashStage.bytes == 0)){
+			g_FlashStage.error = FLASH_STAGE_NO_DATA;
+		}
+
+		if (g_FlashStage.error != FLASH_STAGE_OK){
+			TRACE3("HEX file REJECTED, line %lu: error %u (%d)\n", g_FlashStage.error_line, g_FlashStage.error, g_FlashStage.error_code);
+			TRACE("Nothing was erased, fix the file or the link and burn again.\n\n");
+			g_FlashStage.state = FLASH_STAGE_NONE;
+			return;
+		}
+
+		TRACE3("HEX file OK: %lu lines, %lu bytes, CRC32 %08lX\n", g_FlashStage.lines, g_FlashStage.bytes, g_FlashStage.crc);
+		g_FlashStage.staged_bytes = g_FlashStage.bytes;
+		g_FlashStage.staged_crc = g_FlashStage.crc;
+		g_FlashStage.state = FLASH_STAGE_VALID;
+		return;
+	}
+	else if (ByteCount > MAX_BYTE_COUNT_PER_RECORD_FLASH){
+		error = FLASH_STAGE_BAD_LENGTH;
+	}
+	else if ((ByteCount != 0) && !burn_hex_stage_in_range(Address, ByteCount)){
+		error = FLASH_STAGE_BAD_ADDRESS;
+	}
+
+	if (error != FLASH_STAGE_OK){
+		// only the first one is reported, the rest may just follow from it
+		if (g_FlashStage.error == FLASH_STAGE_OK){
+			g_FlashStage.error = error;
+			g_FlashStage.error_code = return_code;
+			g_FlashStage.error_line = g_FlashStage.lines;
+		}
+		return;
+	}
+
+	burn_hex_stage_add(Address, &DataBuf[0], ByteCount);
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc burn_hex_stage_in_range
+static uint8_t burn_hex_stage_in_range(uint32_t Address, uint8_t ByteCount){
+	uint32_t base;
+	uint32_t end;
+	uint8_t part_id;
+
+	for (part_id = 0; part_id < PARTITION_ID_MAX; part_id++){
+		if ((g_FlashStage.parts & (1 << part_id)) &&
+			(flash_partition_bounds(part_id, &base, &end) == RETURN_NORMAL_VALUE) &&
+			(Address >= base) && (Address + ByteCount - 1 <= end)){
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc burn_hex_stage_add
+static void burn_hex_stage_add(uint32_t Address, const uint8_t *pData, uint8_t ByteCount){
+	uint8_t address[4];
+
+	address[0] = (uint8_t)(Address);
+	address[1] = (uint8_t)(Address >> 8);
+	address[2] = (uint8_t)(Address >> 16);
+	address[3] = (uint8_t)(Address >> 24);
+
+	g_FlashStage.crc = crc32_update(g_FlashStage.crc, &address[0], sizeof(address));
+	g_FlashStage.crc = crc32_update(g_FlashStage.crc, pData, ByteCount);
+	g_FlashStage.bytes += ByteCount;
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc burn_hex_auto_wait
+static void burn_hex_auto_wait(tagBurnHexAuto *pTask, uint32_t Milliseconds){
+	pTask->wait_start_us = TIMESTAMP_US();
+	pTask->wait_us = Milliseconds * 1000;
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc flash_partition_bounds
+static int8_t flash_partition_bounds(uint8_t PartId, uint32_t *pBase, uint32_t *pEnd){
+
+	switch (PartId) {
+		case MAIN_OCM:
+			*pBase = MAIN_OCM_FW_ADDR_BASE;
+			*pEnd = MAIN_OCM_FW_ADDR_END;
+			break;
+		case SECURE_OCM:
+			*pBase = SECURE_OCM_FW_ADDR_BASE;
+			*pEnd = SECURE_OCM_FW_ADDR_END;
+			break;
+		case HDCP_14_22_KEY:
+			*pBase = HDCP_14_22_KEY_ADDR_BASE;
+			*pEnd = HDCP_14_22_KEY_ADDR_END;
+			break;
+		default:
+			return RETURN_FAILURE_VALUE;
+	}
+
+	return RETURN_NORMAL_VALUE;
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc flash_partition_crc32
+static int8_t flash_partition_crc32(uint32_t Address, uint32_t Size, uint32_t *pCrc){
+	uint8_t  ReadDataBuf[FLASH_READ_MAX_LENGTH];
+	uint8_t  RegBak1, RegBak2;  // register values back up
+	uint16_t chunk;
+	int8_t   return_code;
+
+	flash_ocm_stop(&RegBak1, &RegBak2);
+
+	return_code = RETURN_NORMAL_VALUE;
+
+	while(Size != 0){
+		if(flash_read_block(Address, &ReadDataBuf[0]) != RETURN_NORMAL_VALUE){
+			return_code = RETURN_FAILURE_VALUE;
+			break;
+		}
+
+		chunk = (Size > FLASH_READ_MAX_LENGTH) ? FLASH_READ_MAX_LENGTH : (uint16_t)Size;
+		*pCrc = crc32_update(*pCrc, &ReadDataBuf[0], chunk);
+		Address += chunk;
+		Size -= chunk;
+	}
+
+	flash_ocm_restore(RegBak1, RegBak2);
+
+	return return_code;
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc flash_ocm_stop
+static void flash_ocm_stop(uint8_t *pRegBak1, uint8_t *pRegBak2){
+	uint8_t  RegVal;  // register value
+
+	// stop secure OCM to avoid buffer access conflict
+	i2c_read_byte(SLAVEID_DP_IP, ADDR_HDCP2_CTRL, &RegVal);
+	*pRegBak1 = RegVal;
+	RegVal &= (~HDCP2_FW_EN);
+	i2c_write_byte(SLAVEID_DP_IP, ADDR_HDCP2_CTRL, RegVal);
+
+	// stop main OCM to avoid buffer access conflict
+	i2c_read_byte(SLAVEID_SPI, OCM_DEBUG_CTRL, &RegVal);
+	*pRegBak2 = RegVal;
+	RegVal |= OCM_RESET;
+	i2c_write_byte(SLAVEID_SPI, OCM_DEBUG_CTRL, RegVal);
+
+	flash_wait_until_flash_SM_done();
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc flash_ocm_restore
+static void flash_ocm_restore(uint8_t RegBak1, uint8_t RegBak2){
+
+	// restore register value
+	i2c_write_byte(SLAVEID_DP_IP, ADDR_HDCP2_CTRL, RegBak1);
+	i2c_write_byte(SLAVEID_SPI, OCM_DEBUG_CTRL, RegBak2);
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc flash_engine_flush
+static int8_t flash_engine_flush(tagFlashEngine *pEngine){
+	uint8_t  ReadDataBuf[FLASH_READ_MAX_LENGTH];
+	uint32_t Address;
+	uint32_t mask;
+	uint8_t  blank;
+	uint8_t  i;
+	int8_t   return_code;
+	uint32_t timestamp;
+
+	// a block can't go into a sector that is still being erased
+	return_code = flash_engine_erase_done(pEngine, 1);
+	if(return_code != RETURN_NORMAL_VALUE){
+		return return_code;
+	}
+
+	Address = pEngine->block_addr;
+	mask = pEngine->block_mask;
+	pEngine->block_addr = FLASH_ENGINE_NONE;
+	pEngine->block_mask = 0;
+
+	if((Address == FLASH_ENGINE_NONE) || (mask == 0)){
+		return RETURN_NORMAL_VALUE;
+	}
+
+	if(pEngine->sector_mode == FLASH_ENGINE_SECTOR_SKIP){
+		flash_progress_add(flash_engine_mask_bytes(mask));
+		return RETURN_NORMAL_VALUE;
+	}
+
+	if(pEngine->sector_mode == FLASH_ENGINE_SECTOR_PROGRAM){
+		blank = 1;
+		for(i = 0; i < FLASH_WRITE_MAX_LENGTH; i++){
+			if(pEngine->block[i] != 0xFF){
+				blank = 0;
+			}
+		}
+		g_FlashRWinfo.total_bytes_written += flash_engine_mask_bytes(mask);
+
+		if(!blank){
+			flash_write_prepare(Address, (uint8_t)0, FLASH_WRITE_MAX_LENGTH, &pEngine->block[0]);
+			if(flash_actual_write() != RETURN_NORMAL_VALUE){
+				pEngine->sector_ok = 0;
+				if(pEngine->status == RETURN_NORMAL_VALUE){
+					pEngine->status = FLASH_ENGINE_ERR_TIMEOUT;
 				}
-						
-				// TODO: start a timer to check how much time it takes to program the Flash
-				flash_HW_write_protection_enable();
-				break;
+				return FLASH_ENGINE_ERR_TIMEOUT;
 			}
+		}
 
-			if (((Address % FLASH_WRITE_MAX_LENGTH) != 0) && (Address == g_FlashRWinfo.previous_addr + MAX_BYTE_COUNT_PER_RECORD_FLASH)){
-				
-				// contiguous address
-				for (i=0; i<ByteCount; i++){
-					i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_0 + g_FlashRWinfo.bytes_accumulated_in_Ping + i, WriteDataBuf[i]);
-				}
-				
-				flash_writedata_keep(&WriteDataBuf[0], &ReadDataBuf[g_FlashRWinfo.bytes_accumulated_in_Ping], ByteCount);
-				read_ByteCount += ByteCount;
+		if(!(pEngine->flags & FLASH_ENGINE_VERIFY)){
+			flash_progress_add(flash_engine_mask_bytes(mask));
+			return RETURN_NORMAL_VALUE;
+		}
+	}
 
-				flash_actual_write();
-				
-				g_FlashRWinfo.total_bytes_written		+= (g_FlashRWinfo.bytes_accumulated_in_Ping + ByteCount);
-				g_FlashRWinfo.bytes_accumulated_in_Ping = 0;
-				g_FlashRWinfo.previous_addr				= Address;
-				g_FlashRWinfo.prog_is_Ping				= 1;
+	timestamp = TIMESTAMP_US();
+	return_code = flash_read_block(Address, &ReadDataBuf[0]);
+	FLASH_TIMING_ADD(verify_us, timestamp);
+
+	// only the bytes a record wrote are known
+	if(return_code == RETURN_NORMAL_VALUE){
+		for(i = 0; i < FLASH_WRITE_MAX_LENGTH; i++){
+			if((mask & ((uint32_t)1 << i)) && (ReadDataBuf[i] != pEngine->block[i])){
+				return_code = RETURN_FAILURE_VALUE;
+				break;
 			}
+		}
+	}
 
-			else if (((Address % FLASH_WRITE_MAX_LENGTH) != 0) && (Address != g_FlashRWinfo.previous_addr + MAX_BYTE_COUNT_PER_RECORD_FLASH) ){
-				
-				// address is not contiguous
-				for (i=0; i<MAX_BYTE_COUNT_PER_RECORD_FLASH; i++){
-					i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_0 + MAX_BYTE_COUNT_PER_RECORD_FLASH + i, 0xFF);
-				}
-				
-				flash_write_enable();
-				
-				i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_H, g_FlashRWinfo.previous_addr >> 8);
-				i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_L, g_FlashRWinfo.previous_addr & 0xFF);
-				flash_actual_write();  // write what was received in ping
-				
-				g_FlashRWinfo.total_bytes_written += g_FlashRWinfo.bytes_accumulated_in_Ping;
-				g_FlashRWinfo.bytes_accumulated_in_Ping = 0;
+	if(return_code == RETURN_NORMAL_VALUE){
+		flash_progress_add(flash_engine_mask_bytes(mask));
+		return RETURN_NORMAL_VALUE;
+	}
 
-				for (i=0; i<MAX_BYTE_COUNT_PER_RECORD_FLASH; i++){
-					i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_0 + i, 0xFF);
-				}
-				
-				flash_write_prepare(Address - MAX_BYTE_COUNT_PER_RECORD_FLASH, (uint8_t)MAX_BYTE_COUNT_PER_RECORD_FLASH, ByteCount, &WriteDataBuf[0]);
-				flash_actual_write();  // write what is received in this pong
-				
-				g_FlashRWinfo.total_bytes_written += ByteCount;
-				g_FlashRWinfo.previous_addr = Address;
-				g_FlashRWinfo.prog_is_Ping = 1;
-			}
-			
-			else if (((Address % FLASH_WRITE_MAX_LENGTH) == 0) && (Address != g_FlashRWinfo.previous_addr + MAX_BYTE_COUNT_PER_RECORD_FLASH)){
-				for (i=0; i<MAX_BYTE_COUNT_PER_RECORD_FLASH; i++){
-					i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_0 + MAX_BYTE_COUNT_PER_RECORD_FLASH + i, 0xFF);
-				}
-				flash_write_enable();
-				
-				i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_H, g_FlashRWinfo.previous_addr >> 8);
-				i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_L, g_FlashRWinfo.previous_addr & 0xFF);
-				
-				flash_actual_write();  // write what was received in ping
-				
-				g_FlashRWinfo.total_bytes_written += g_FlashRWinfo.bytes_accumulated_in_Ping;
-				g_FlashRWinfo.bytes_accumulated_in_Ping = 0;
-				goto auto_write_prepare_in_ping;
+	pEngine->sector_ok = 0;
+
+	if(pEngine->sector_mode == FLASH_ENGINE_SECTOR_CHECK){
+		// the journal was wrong about this sector, make the next run redo it
+		flash_journal_mark(pEngine->pJournal, pEngine->sector_addr, FLASH_SECTOR_UNTOUCHED);
+		pEngine->sector_mode = FLASH_ENGINE_SECTOR_SKIP;
+		return_code = FLASH_ENGINE_ERR_RESUME;
+	}
+	else{
+		#ifdef FALSH_READ_BACK
+			g_bFlashResult = 1;
+		#endif
+		return_code = FLASH_ENGINE_ERR_VERIFY;
+	}
+
+	if(pEngine->status == RETURN_NORMAL_VALUE){
+		pEngine->status = return_code;
+	}
+
+	return return_code;
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc flash_engine_erase_done
+static int8_t flash_engine_erase_done(tagFlashEngine *pEngine, uint8_t Wait){
+	uint8_t  tmp;
+	uint32_t interval;
+	int8_t   return_code;
+
+	if(!pEngine->erase_pending){
+		return RETURN_NORMAL_VALUE;
+	}
+
+	return_code = RETURN_NORMAL_VALUE;
+
+	#ifndef  DRY_RUN
+		interval = FLASH_POLL_INTERVAL_MIN;
+
+		while(1){
+			read_status_enable();
+
+			// read STATUS_REGISTER
+			i2c_read_byte(SLAVEID_SPI, R_FLASH_STATUS_4, &tmp);
+			g_FlashTiming.wip_polls++;
+
+			if((tmp & 1) == 0){
+				break;
 			}
-			else{
-				TRACE("\nInternal ERROR in flash_program()!!!\n");
+
+			if((TIMESTAMP_US() - pEngine->erase_start_us) >= g_FlashOpTime[FLASH_OP_SECTOR_ERASE].max_us){
+				g_FlashTiming.timeouts++;
+				return_code = RETURN_FAILURE_VALUE;
+				break;
 			}
-		
-			// read Flash data back
-			//flash_wait_until_flash_SM_done();
 
-			/* =============== Reads 32 bytes =============== */
-			if(read_ByteCount>(MAX_BYTE_COUNT_PER_RECORD_FLASH*2)){
-				read_Count = (MAX_BYTE_COUNT_PER_RECORD_FLASH*2);
+			if(!Wait){
+				return FLASH_ENGINE_BUSY;
 			}
-			else{
-				read_Count = read_ByteCount;
+
+			flash_sleep_us(interval);
+			if(interval < FLASH_POLL_INTERVAL_MAX){
+				interval *= 2;
 			}
+		}
+	#endif
 
-			i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_H, read_Address >> 8);
-			i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_L, read_Address & 0xFF);
+	if((return_code == RETURN_NORMAL_VALUE) && (flash_wait_until_flash_SM_done() != RETURN_NORMAL_VALUE)){
+		return_code = RETURN_FAILURE_VALUE;
+	}
 
-			i2c_write_byte(SLAVEID_SPI, R_FLASH_LEN_H, 0);
-			i2c_write_byte(SLAVEID_SPI, R_FLASH_LEN_L, FLASH_READ_MAX_LENGTH - 1);
+	pEngine->erase_pending = 0;
+	FLASH_TIMING_ADD(erase_us, pEngine->erase_start_us);
 
-			ocm_read_enable();
-			
-			flash_wait_until_flash_SM_done();
-			
-			/* =============== Reads 32 bytes =============== */
-			for (i=0; i<read_Count; i++){
-				i2c_read_byte(SLAVEID_SPI, FLASH_READ_D0 + i, &read_result);
-				
-				TRACE1("%B02X",read_result);
-				
-				if(read_result!=ReadDataBuf[i]){
-					g_bFlashResult = 1;
-				}
-			}
+	if(return_code != RETURN_NORMAL_VALUE){
+		pEngine->sector_ok = 0;
+		if(pEngine->status == RETURN_NORMAL_VALUE){
+			pEngine->status = FLASH_ENGINE_ERR_TIMEOUT;
 		}
-		hex_index++;
-	}while(1);
+		return FLASH_ENGINE_ERR_TIMEOUT;
+	}
 
-	// restore register value
-	i2c_write_byte(SLAVEID_DP_IP, ADDR_HDCP2_CTRL, RegBak1);  
-	
-	// TODO
-	// restore register value
-	i2c_write_byte(SLAVEID_SPI, OCM_DEBUG_CTRL, RegBak2);  
-	delay_ms(100);
-	
-	// RESET chicago after burn done
-	chicago_power_onoff(0);
-	delay_ms(100);
-	
-	chicago_power_supply(0);
-	delay_ms(100);
-	
-	chicago_power_supply(1);
+	if(pEngine->pJournal != NULL){
+		flash_journal_mark(pEngine->pJournal, pEngine->sector_addr, FLASH_SECTOR_ERASED);
+	}
 
-    return RETURN_NORMAL_VALUE;
+	return RETURN_NORMAL_VALUE;
 }
 
 //-----------------------------------------------------------------------------
-/// @copydoc flash_wait_until_WIP_cleared
-static void flash_wait_until_WIP_cleared(void){
-	uint8_t  tmp;
-	
-	do{
-		read_status_enable();
-		
-		// read STATUS_REGISTER
-		i2c_read_byte(SLAVEID_SPI, R_FLASH_STATUS_4, &tmp);
-	}while((tmp & 1) != 0);
+/// @copydoc flash_engine_mask_bytes
+static uint8_t flash_engine_mask_bytes(uint32_t Mask){
+	uint8_t count;
+
+	for(count = 0; Mask != 0; Mask &= Mask - 1){
+		count++;
+	}
+
+	return count;
 }
 
 //-----------------------------------------------------------------------------
-/// @copydoc flash_wait_until_flash_SM_done
-static void flash_wait_until_flash_SM_done(void){
-	uint8_t  tmp;
-	
-	do{
-		i2c_read_byte(SLAVEID_SPI, R_RAM_CTRL, &tmp);
-	}while( (tmp&FLASH_DONE)==0 );
+/// @copydoc flash_progress_report
+static void flash_progress_report(void){
+	tagFlashProgress *pReport = &g_FlashProgress.report;
+	uint32_t now;
+	uint32_t elapsed_us;
+	uint32_t delta_us;
+
+	if(g_FlashProgress.callback == NULL){
+		return;
+	}
+
+	now = TIMESTAMP_US();
+	elapsed_us = now - g_FlashProgress.start_us;
+	delta_us = now - g_FlashProgress.last_us;
+
+	pReport->elapsed_ms = elapsed_us / 1000;
+	pReport->avg_bps = (elapsed_us != 0) ? (uint32_t)((uint64_t)pReport->bytes_done * 1000000 / elapsed_us) : 0;
+	pReport->rate_bps = (delta_us != 0) ?
+		(uint32_t)((uint64_t)(pReport->bytes_done - g_FlashProgress.last_bytes) * 1000000 / delta_us) : 0;
+
+	if((pReport->bytes_total != 0) && (pReport->bytes_done >= pReport->bytes_total)){
+		pReport->eta_ms = 0;
+	}
+	else if((pReport->bytes_total == 0) || (pReport->avg_bps == 0)){
+		pReport->eta_ms = FLASH_PROGRESS_ETA_UNKNOWN;
+	}
+	else{
+		pReport->eta_ms = (uint32_t)((uint64_t)(pReport->bytes_total - pReport->bytes_done) * 1000 / pReport->avg_bps);
+	}
+
+	g_FlashProgress.last_us = now;
+	g_FlashProgress.last_bytes = pReport->bytes_done;
+
+	g_FlashProgress.callback(pReport, g_FlashProgress.pContext);
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc flash_engine_enter_sector
+static int8_t flash_engine_enter_sector(tagFlashEngine *pEngine, uint32_t SectorAddr){
+	uint16_t bit;
+
+	bit = FLASH_ENGINE_SECTOR_BIT(SectorAddr);
+
+	pEngine->sector_addr = SectorAddr;
+	pEngine->sector_mode = FLASH_ENGINE_SECTOR_PROGRAM;
+	pEngine->sector_ok = 1;
+
+	// the journal only speaks for sectors this run hasn't touched yet
+	if((pEngine->pJournal != NULL) && !(pEngine->sectors_visited & bit) &&
+	   (flash_journal_state(pEngine->pJournal, SectorAddr) == FLASH_SECTOR_VERIFIED)){
+		if(flash_journal_state(pEngine->pJournal, SectorAddr + FLASH_SECTOR_SIZE) == FLASH_SECTOR_VERIFIED){
+			pEngine->sector_mode = FLASH_ENGINE_SECTOR_SKIP;
+		}
+		else{
+			// the last good sector before the interruption, check it before building on it
+			pEngine->sector_mode = FLASH_ENGINE_SECTOR_CHECK;
+			TRACE1("Resuming at 0x%04X\n", SectorAddr);
+		}
+	}
+
+	pEngine->sectors_visited |= bit;
+
+	if((pEngine->sector_mode == FLASH_ENGINE_SECTOR_PROGRAM) && (pEngine->flags & FLASH_ENGINE_ERASE) &&
+	   !(pEngine->sectors_erased & bit)){
+		// anything short of verified may be half written, so the sector starts over
+		if(pEngine->flags & FLASH_ENGINE_ASYNC){
+			flash_sector_erase(SectorAddr);
+			pEngine->erase_pending = 1;
+			pEngine->erase_start_us = TIMESTAMP_US();
+			pEngine->sectors_erased |= bit;
+			return RETURN_NORMAL_VALUE;
+		}
+
+		if(flash_erase_sector(SectorAddr) != RETURN_NORMAL_VALUE){
+			pEngine->sector_ok = 0;
+			if(pEngine->status == RETURN_NORMAL_VALUE){
+				pEngine->status = FLASH_ENGINE_ERR_TIMEOUT;
+			}
+			return FLASH_ENGINE_ERR_TIMEOUT;
+		}
+		pEngine->sectors_erased |= bit;
+
+		if(pEngine->pJournal != NULL){
+			flash_journal_mark(pEngine->pJournal, SectorAddr, FLASH_SECTOR_ERASED);
+		}
+	}
+
+	return RETURN_NORMAL_VALUE;
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc flash_engine_leave_sector
+static void flash_engine_leave_sector(tagFlashEngine *pEngine){
+
+	if((pEngine->sector_addr == FLASH_ENGINE_NONE) || (pEngine->pJournal == NULL) ||
+	   (pEngine->sector_mode != FLASH_ENGINE_SECTOR_PROGRAM)){
+		return;
+	}
+
+	flash_journal_mark(pEngine->pJournal, pEngine->sector_addr, FLASH_SECTOR_PROGRAMMED);
+
+	if((pEngine->flags & FLASH_ENGINE_VERIFY) && pEngine->sector_ok){
+		flash_journal_mark(pEngine->pJournal, pEngine->sector_addr, FLASH_SECTOR_VERIFIED);
+	}
 }
 
 //-----------------------------------------------------------------------------
 /// @copydoc flash_HW_write_protection_enable
 static void flash_HW_write_protection_enable(void){
 	uint8_t RegData;
+	uint32_t timestamp;
+
+	timestamp = TIMESTAMP_US();
 
 	// 1: flash not wp
 	i2c_read_byte(SLAVEID_SPI, GPIO_STATUS_1, &RegData);
@@ -881,7 +1730,7 @@ static void flash_HW_write_protection_enable(void){
 	flash_write_status_register(RegData);
 	
 	#ifndef  DRY_RUN
-	flash_wait_until_WIP_cleared();
+	flash_wait_until_WIP_cleared(FLASH_OP_STATUS_WRITE);
 	#endif
 
 	// 0: flash wp, hardware write protected
@@ -896,6 +1745,8 @@ static void flash_HW_write_protection_enable(void){
 	i2c_read_byte(SLAVEID_SPI, R_FLASH_STATUS_4, &RegData);
 	flash_wait_until_flash_SM_done();
 
+	FLASH_TIMING_ADD(wp_enable_us, timestamp);
+
 	if ((RegData & FLASH_PROTECTION_PATTERN_MASK) == HW_FLASH_PROTECTION_PATTERN){
 		TRACE("Flash hardware write protection enabled.\n");
 	}
@@ -908,6 +1759,9 @@ static void flash_HW_write_protection_enable(void){
 /// @copydoc flash_write_protection_disable
 static void flash_write_protection_disable(void){
 	uint8_t RegData;
+	uint32_t timestamp;
+
+	timestamp = TIMESTAMP_US();
 
 	// WP# pin of Flash die = high, not hardware write protected
 	i2c_read_byte(SLAVEID_SPI, GPIO_STATUS_1, &RegData);
@@ -919,7 +1773,7 @@ static void flash_write_protection_disable(void){
 	flash_write_status_register(RegData);
 
 	#ifndef  DRY_RUN
-	flash_wait_until_WIP_cleared();
+	flash_wait_until_WIP_cleared(FLASH_OP_STATUS_WRITE);
 	#endif
 
 	flash_wait_until_flash_SM_done();
@@ -929,6 +1783,8 @@ static void flash_write_protection_disable(void){
 	i2c_read_byte(SLAVEID_SPI, R_FLASH_STATUS_4, &RegData);
 	flash_wait_until_flash_SM_done();
 
+	FLASH_TIMING_ADD(wp_disable_us, timestamp);
+
 	if ((RegData & FLASH_PROTECTION_PATTERN_MASK) == 0 ){
 		TRACE("Flash write protection disabled.\n");
 	}
@@ -951,49 +1807,48 @@ static void HEX_file_validity_check(uint32_t Address, uint8_t ByteCount, int8_t
 		TRACE("Please power cycle the EVB and check the HEX file!\n");
 		while(1);  /* hangs deliberately so that the user can see it */
 	}
-
-	if ((Address % MAX_BYTE_COUNT_PER_RECORD_FLASH) != 0 ){
-		TRACE2("ERROR! Address = 0x%04X, not %bu bytes aligned.\n", Address, MAX_BYTE_COUNT_PER_RECORD_FLASH);
-		TRACE("Please power cycle the EVB and check the HEX file!\n");
-		while(1);  /* hangs deliberately so that the user can see it */
-	}
 }
 
 //-----------------------------------------------------------------------------
 /// @copydoc flash_write_prepare
 static void flash_write_prepare(uint32_t Address, uint8_t offset, uint8_t ByteCount, uint8_t *WriteDataBuf){
-	uint8_t i;  /* counter */
+	uint32_t timestamp;
+
+	timestamp = TIMESTAMP_US();
 
 	flash_write_enable();
 
 	i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_H, Address >> 8);
 	i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_L, Address & 0xFF);
 
-	for (i=0; i<ByteCount; i++){
-		i2c_write_byte(SLAVEID_SPI, R_FLASH_ADDR_0 + offset + i, WriteDataBuf[i]);
-	}
-}
-
-//-----------------------------------------------------------------------------
-/// @copydoc flash_writedata_keep
-static void flash_writedata_keep(uint8_t *WriteDataBuf, uint8_t *ReadDataBuf,uint8_t ByteCount){
-	uint8_t i;  /* counter */
+	// R_FLASH_ADDR_0.. auto-increments, a few transactions instead of 2 per byte
+	i2c_write_block(SLAVEID_SPI, R_FLASH_ADDR_0 + offset, WriteDataBuf, ByteCount);
 
-	for (i=0; i<ByteCount; i++){
-		*(ReadDataBuf+i) = *(WriteDataBuf+i);
-	}
+	FLASH_TIMING_ADD(staging_us, timestamp);
 }
 
 //-----------------------------------------------------------------------------
 /// @copydoc flash_actual_write
-static void flash_actual_write(void){
+static int8_t flash_actual_write(void){
+	uint32_t timestamp;
+	int8_t return_code = RETURN_NORMAL_VALUE;
+
+	timestamp = TIMESTAMP_US();
+
 	#ifndef  DRY_RUN
-	flash_wait_until_WIP_cleared();
-	ocm_write_enable();
-	flash_wait_until_WIP_cleared();
+	return_code = flash_wait_until_WIP_cleared(FLASH_OP_IDLE);
+	if(return_code == RETURN_NORMAL_VALUE){
+		ocm_write_enable();
+		return_code = flash_wait_until_WIP_cleared(FLASH_OP_PAGE_PROGRAM);
+	}
 	#endif
 
-	flash_wait_until_flash_SM_done();
+	if(flash_wait_until_flash_SM_done() != RETURN_NORMAL_VALUE){
+		return_code = RETURN_FAILURE_VALUE;
+	}
+	FLASH_TIMING_ADD(program_us, timestamp);
+
+	return return_code;
 }
 
 //-----------------------------------------------------------------------------
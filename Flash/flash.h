@@ -27,12 +27,23 @@
 *	In most circumstances, the only one of interest to the end user is 
 *	burn_hex_auto(). However, more detailed information can be found in 
 *	ANX753X_Programming_Guide.pdf, page 35.
+*
+*	Every way of getting an image into flash - HEX lines over the console,
+*	the embedded OCM image, or a source added later - goes through the same
+*	engine: flash_engine_begin(), then flash_engine_write() for push sources
+*	or flash_engine_run() for pull sources, then flash_engine_end(). The
+*	engine packs the data into aligned 32 byte blocks, erases, programs and
+*	verifies, so sources only have to produce address/data records.
 */
 
 
 #ifndef __FLASH_H__
 	#define __FLASH_H__
 
+	#include "./flashJournal.h"
+	#include "./ocmImage.h"
+	#include "../Chicago/chicago_registers.h"
+
 	//#############################################################################
 	// Pre-compiler Definitions
 	//-----------------------------------------------------------------------------
@@ -55,6 +66,107 @@
 	#define  HDCP_14_22_KEY_ADDR_BASE		0x9000
 	#define  HDCP_14_22_KEY_ADDR_END		0x9FFF
 
+	// \readbin frame: SYNC0 SYNC1 type addr[4] len[2] payload[len] crc32[4]
+	// All fields little endian; the CRC covers type through the end of payload.
+	#define  FLASH_DUMP_SYNC0				0xA5
+	#define  FLASH_DUMP_SYNC1				0x5A
+	#define  FLASH_DUMP_TYPE_DATA			'D'
+	#define  FLASH_DUMP_TYPE_END			'E'		// payload: crc32 of all data, addr: next address
+	#define  FLASH_DUMP_HEADER_SIZE			9
+	#define  FLASH_DUMP_FRAME_DATA_SIZE		256
+
+	// flash_engine_begin() flags
+	#define  FLASH_ENGINE_ERASE				0x01	// erase each sector before its first write
+	#define  FLASH_ENGINE_VERIFY			0x02	// read back each block after programming
+	#define  FLASH_ENGINE_ASYNC				0x04	// start sector erases and return, see flash_engine_poll()
+
+	// flash_engine_poll(): a sector erase is still running
+	#define  FLASH_ENGINE_BUSY				1
+
+	// flash_engine_write() / flash_engine_run() failures, sources may add their own
+	#define  FLASH_ENGINE_ERR_VERIFY		RETURN_FAILURE_VALUE	// read back differs
+	#define  FLASH_ENGINE_ERR_RESUME		RETURN_FAILURE_VALUE2	// a journaled sector failed its re-check, run again
+	#define  FLASH_ENGINE_ERR_TIMEOUT		RETURN_FAILURE_VALUE3	// flash stayed busy past its maximum time
+
+	// flash_wait_until_WIP_cleared() operations, index g_FlashOpTime[]
+	#define  FLASH_OP_IDLE					0		// nothing should be running, just make sure
+	#define  FLASH_OP_PAGE_PROGRAM			1
+	#define  FLASH_OP_SECTOR_ERASE			2
+	#define  FLASH_OP_BLOCK_ERASE			3
+	#define  FLASH_OP_CHIP_ERASE			4
+	#define  FLASH_OP_STATUS_WRITE			5
+	#define  FLASH_OP_COUNT					6
+
+	// Typical and maximum busy times in us, generic 512 Kbit SPI NOR datasheet
+	// figures. The wait sleeps for the typical time, then polls with backoff
+	// and gives up after the maximum.
+	#define  FLASH_TIME_PAGE_PROGRAM_TYP	700
+	#define  FLASH_TIME_PAGE_PROGRAM_MAX	3000
+	#define  FLASH_TIME_SECTOR_ERASE_TYP	45000
+	#define  FLASH_TIME_SECTOR_ERASE_MAX	400000
+	#define  FLASH_TIME_BLOCK_ERASE_TYP		150000
+	#define  FLASH_TIME_BLOCK_ERASE_MAX		2000000
+	#define  FLASH_TIME_CHIP_ERASE_TYP		1000000
+	#define  FLASH_TIME_CHIP_ERASE_MAX		10000000
+	#define  FLASH_TIME_STATUS_WRITE_TYP	10000
+	#define  FLASH_TIME_STATUS_WRITE_MAX	15000
+
+	// The controller state machine only shifts a command or 32 bytes out on
+	// SPI, so it is polled straight away
+	#define  FLASH_TIME_SM_MAX				20000
+
+	// backoff between polls
+	#define  FLASH_POLL_INTERVAL_MIN		20
+	#define  FLASH_POLL_INTERVAL_MAX		10000
+
+	// burn_hex_auto(): time the boot loader gets to CRC check the new image
+	#define  FLASH_BOOT_CHECK_TIMEOUT_MS	1000
+	#define  FLASH_BOOT_CHECK_INTERVAL_MS	10
+
+	// burn_hex_auto_step() states, in the order they run
+	#define  BURN_AUTO_START				0	// power on, quick checks
+	#define  BURN_AUTO_CHECK				1	// compare non-MAIN partitions with flash, a chunk per step
+	#define  BURN_AUTO_DECIDE				2	// journal, image check, start the engine
+	#define  BURN_AUTO_PROGRAM				3	// one record, or one erase poll, per step
+	#define  BURN_AUTO_FINISH				4	// close the engine and the journal
+	#define  BURN_AUTO_POWER_OFF			5
+	#define  BURN_AUTO_SUPPLY_OFF			6
+	#define  BURN_AUTO_SUPPLY_ON			7
+	#define  BURN_AUTO_BOOT_CHECK			8	// poll HDCP_LOAD_STATUS
+	#define  BURN_AUTO_DONE					9	// finished, everything from here on
+	#define  BURN_AUTO_UP_TO_DATE			10
+	#define  BURN_AUTO_FAILED				11
+
+	// g_bFlashWrite, what flash_program() does with a console line
+	#define  FLASH_WRITE_OFF				0
+	#define  FLASH_WRITE_PROGRAM			1	// hand it to the flash engine
+	#define  FLASH_WRITE_STAGE				2	// check it only, see burn_hex_stage_prepare()
+
+	// tagFlashStage.state
+	#define  FLASH_STAGE_NONE				0
+	#define  FLASH_STAGE_CHECKING			1	// first transfer, nothing is written
+	#define  FLASH_STAGE_VALID				2	// first transfer checked out, erase and send again
+	#define  FLASH_STAGE_PROGRAMMING		3	// second transfer, must match the first
+
+	// tagFlashStage.error
+	#define  FLASH_STAGE_OK					0
+	#define  FLASH_STAGE_BAD_LINE			1	// GetLineData() failed, see error_code
+	#define  FLASH_STAGE_BAD_LENGTH			2	// more than MAX_BYTE_COUNT_PER_RECORD_FLASH bytes
+	#define  FLASH_STAGE_BAD_ADDRESS		3	// outside the partitions given to \burnhex
+	#define  FLASH_STAGE_NO_DATA			4
+
+	// tagFlashProgress.phase
+	#define  FLASH_PHASE_CHECK				0	// comparing flash with the image, nothing written
+	#define  FLASH_PHASE_PROGRAM			1	// erase, program and read back
+	#define  FLASH_PHASE_BOOT				2	// new image written, waiting for the boot CRC checks
+
+	#define  FLASH_PROGRESS_GRANULARITY		1024	// default bytes between callbacks
+	#define  FLASH_PROGRESS_ETA_UNKNOWN		0xFFFFFFFFUL
+
+	#define  BURN_AUTO_POWER_DELAY_MS		100
+	#define  BURN_AUTO_CHECK_CHUNK			512		// BURN_AUTO_CHECK bytes per step
+	#define  BURN_AUTO_ERASE_POLL_US		2000	// once an erase is past FLASH_TIME_SECTOR_ERASE_TYP
+
 	#define read_status_enable() \
 		do{ \
 			uint8_t tmp; \
@@ -140,24 +252,164 @@
 	typedef struct
 	{
 		unsigned long  total_bytes_written;
-		uint32_t   previous_addr;
-		uint8_t  prog_is_Ping;
-		uint8_t  bytes_accumulated_in_Ping;
 	} tagFlashRWinfo;
 
+	// One run of address/data from a flash source
+	typedef struct
+	{
+		uint32_t address;
+		uint8_t  length;				// up to FLASH_WRITE_MAX_LENGTH
+		uint8_t  data[FLASH_WRITE_MAX_LENGTH];
+	} tagFlashRecord;
+
+	// Fill pRecord with the next record. Returns 1 if it did, 0 at the end of
+	// the source, or a negative error that flash_engine_run() passes on.
+	typedef int8_t (*FlashSourceNext_t)(void *pContext, tagFlashRecord *pRecord);
+
+	typedef struct
+	{
+		FlashSourceNext_t next;
+		void *pContext;
+	} tagFlashSource;
+
+	// Programming state between flash_engine_begin() and flash_engine_end()
+	typedef struct
+	{
+		uint8_t  flags;					// FLASH_ENGINE_xxx
+		int8_t   status;				// first failure, RETURN_NORMAL_VALUE if none
+		tagFlashJournal *pJournal;		// NULL to run without resume support
+
+		uint32_t sector_addr;			// sector being written, FLASH_ENGINE_NONE before the first
+		uint8_t  sector_mode;			// FLASH_ENGINE_SECTOR_xxx
+		uint8_t  sector_ok;				// every read back in this sector matched
+		uint16_t sectors_visited;		// one bit per sector entered by this run
+		uint16_t sectors_erased;		// one bit per sector erased by this run
+
+		uint32_t block_addr;			// aligned address of block[], FLASH_ENGINE_NONE when empty
+		uint32_t block_mask;			// one bit per byte of block[] a record wrote
+		uint8_t  block[FLASH_WRITE_MAX_LENGTH];
+
+		uint8_t  erase_pending;			// FLASH_ENGINE_ASYNC erase started, not yet seen done
+		uint32_t erase_start_us;
+
+		uint8_t  RegBak1, RegBak2;		// OCM registers to restore at the end
+	} tagFlashEngine;
+
+	// flash_source_ocm_image() context, walks one partition in HEX_LINE_SIZE records
+	typedef struct
+	{
+		tagOcmImageStream stream;
+		uint8_t  part_id;			// MAIN_OCM, SECURE_OCM or HDCP_14_22_KEY
+		uint32_t hex_lines;			// MAIN_OCM only, see burn_hex_auto_offset()
+		uint32_t address;			// next record
+		uint32_t base;				// partition bounds
+		uint32_t end;
+	} tagOcmImageSource;
+
+	// burn_hex_auto_step() state, see burn_hex_auto_begin()
+	typedef struct
+	{
+		uint8_t  state;					// BURN_AUTO_xxx
+		int8_t   result;				// burn_hex_auto() return value once finished
+		uint8_t  update_parts;			// one bit per PARTITION_ID to program
+		uint8_t  check_parts;			// one bit per PARTITION_ID still to compare with flash
+		uint8_t  part_id;				// partition being compared or programmed
+		uint8_t  retries;				// FLASH_ENGINE_ERR_RESUME runs so far
+		uint8_t  crc_bits;				// HDCP_LOAD_STATUS bits the new image must set
+		uint32_t crc;					// BURN_AUTO_CHECK running CRC32
+		uint32_t crc_addr;				// BURN_AUTO_CHECK next address
+		uint32_t wait_start_us;			// power sequencing or boot check delay
+		uint32_t wait_us;
+		uint32_t boot_start_us;
+		tagFlashJournal journal;
+		tagFlashEngine engine;
+		tagOcmImageSource source;
+	} tagBurnHexAuto;
+
+	// \burnhex <ids> stage, the first transfer's summary
+	typedef struct
+	{
+		uint8_t  state;					// FLASH_STAGE_xxx
+		uint8_t  parts;					// one bit per PARTITION_ID the file may write
+		uint8_t  error;					// FLASH_STAGE_xxx of the first bad line
+		int8_t   error_code;			// GetLineData() return for FLASH_STAGE_BAD_LINE
+		uint32_t error_line;
+		uint32_t lines;
+		uint32_t bytes;					// data bytes so far
+		uint32_t crc;					// CRC32 over each data record's address and data
+		uint32_t staged_bytes;			// bytes and crc of the transfer that checked out
+		uint32_t staged_crc;
+	} tagFlashStage;
+
+	// What a flash_progress_set() callback is told
+	typedef struct
+	{
+		uint8_t  phase;					// FLASH_PHASE_xxx
+		uint32_t bytes_done;
+		uint32_t bytes_total;			// 0 if not known, e.g. a HEX file over the console
+		uint32_t elapsed_ms;			// since the phase started
+		uint32_t rate_bps;				// bytes per second since the previous callback
+		uint32_t avg_bps;				// bytes per second since the phase started
+		uint32_t eta_ms;				// FLASH_PROGRESS_ETA_UNKNOWN without a total or a rate yet
+	} tagFlashProgress;
+
+	typedef void (*FlashProgress_t)(const tagFlashProgress *pProgress, void *pContext);
+
+	// flash_progress_xxx() bookkeeping
+	typedef struct
+	{
+		FlashProgress_t callback;		// NULL for none
+		void     *pContext;
+		uint32_t granularity;			// bytes between callbacks
+		uint32_t start_us;				// TIMESTAMP_US() at flash_progress_begin()
+		uint32_t last_us;				// TIMESTAMP_US() at the previous callback
+		uint32_t last_bytes;			// bytes_done at the previous callback
+		tagFlashProgress report;
+	} tagFlashProgressState;
+
+	// Per-phase flash timing in microseconds, reset at the start of every
+	// burn. WIP and SM waits are also counted inside erase, program, verify
+	// and the WP phases, so they show where those phases spend their time.
+	typedef struct
+	{
+		uint32_t start_us;			// TIMESTAMP_US() at flash_timing_reset()
+		uint32_t total_us;
+		uint32_t ocm_stop_us;		// halting main and secure OCM
+		uint32_t erase_us;
+		uint32_t staging_us;		// write enable, address and data into R_FLASH_ADDR_x
+		uint32_t program_us;		// flash_actual_write()
+		uint32_t verify_us;			// read back
+		uint32_t wp_disable_us;
+		uint32_t wp_enable_us;
+		uint32_t wip_wait_us;		// flash_wait_until_WIP_cleared()
+		uint32_t sm_wait_us;		// flash_wait_until_flash_SM_done()
+		uint32_t wip_polls;
+		uint32_t sm_polls;
+		uint32_t timeouts;			// waits that hit their maximum time
+	} tagFlashTiming;
+
+	// Busy time of one flash operation, see FLASH_TIME_xxx
+	typedef struct
+	{
+		uint32_t typ_us;
+		uint32_t max_us;
+	} tagFlashOpTime;
+
 
 	//#############################################################################
 	// Function Prototypes
 	//-----------------------------------------------------------------------------
 	/**
 	 * @brief 
-	 *		Program flash with data in a HEX file, 32 bytes at a time.
+	 *		Program flash with one line of a HEX file
 	 * @details 
-	 *		In some special cases, 16 bytes at a time. When the address is not 
-	 *		16-byte aligned, simply notify the user and hangs deliberately. The 
-	 *		address is always 16-byte aligned, and 16 or 32 bytes are written into 
-	 *		Flash at a time, with some special handling, crossing 256-byte (Flash 
-	 *		page size) boundary will NEVER happen, thus no need to handle this.
+	 *		Called once per received line while g_bFlashWrite is set. The line
+	 *		is handed to the flash engine, which programs and verifies a block
+	 *		as soon as the records in it are complete; any record alignment
+	 *		works. The EOF record flushes the last block.
+	 *
+	 *		Under FLASH_WRITE_STAGE the line is only checked, see
+	 *		burn_hex_stage_prepare().
 	 * @note 
 	 *		This function only programs the Flash; it does NOT automatically 
 	 *		erase flash or even backup the data. Erasing Flash properly is the 
@@ -207,6 +459,21 @@
 	 */		
 	void command_flash_read(uint32_t Address, uint64_t size_to_be_read);
 
+	/**
+	 * @brief 
+	 *		Reads flash and streams it raw over the UART in CRC32-protected frames
+	 * @details
+	 *		Much faster than \\readhex: flash is fetched with burst reads and sent
+	 *		without any formatting. Use Host/flash_dump.cpp to receive the frames
+	 *		and save them as a .bin or .hex file.
+	 * @ingroup Chicago_flash
+	 * @note Command line usage: \\readbin (base_address) (size_to_be_read)
+	 * @param Address - Flash address, 16-byte aligned
+	 * @param size_to_be_read - Number of bytes to read
+	 * @return void
+	 */		
+	void command_flash_read_bin(uint32_t Address, uint32_t size_to_be_read);
+
 	/**
 	 * @brief 
 	 *		Flash programming preparation routine
@@ -214,31 +481,523 @@
 	 * @return void
 	 */	
 	void burn_hex_prepare(void);
+
+	/**
+	 * @brief 
+	 *		Start the check pass of a staged \burnhex
+	 * @details
+	 *		A whole partition doesn't fit in MCU RAM, so the HEX file is sent
+	 *		twice. The first transfer is only checked: every line's checksum,
+	 *		record length, and every byte landing inside Parts, with a CRC32
+	 *		over the lot. Nothing is erased until it checks out. The second
+	 *		transfer is programmed and must match the first CRC32 and length.
+	 *
+	 *		A line starting with '\' abandons the check pass.
+	 * @ingroup Chicago_flash
+	 * @param Parts - One bit per PARTITION_ID the file may write
+	 * @return void
+	 */	
+	void burn_hex_stage_prepare(uint8_t Parts);
+
+	/**
+	 * @brief 
+	 *		Tell whether a check pass just finished cleanly
+	 * @details
+	 *		The caller then erases the partitions and calls burn_hex_prepare(),
+	 *		which arms the comparison for the second transfer.
+	 * @ingroup Chicago_flash
+	 * @return uint8_t - Partition bits to erase, 0 if nothing is waiting
+	 */	
+	uint8_t burn_hex_stage_ready(void);
 	
 	/**
 	 * @brief 
 	 *		Automatically determines whether flash needs updating and burns
 	 *		hex file if it does 
+	 * @details
+	 *		Every partition in the embedded bundle is checked on its own:
+	 *		- MAIN_OCM updates if the OCM reports an older version or fails its
+	 *		  boot CRC check (OCM_FW_CRC32 in HDCP_LOAD_STATUS). The version and
+	 *		  CRC32 come from ocm_info.h, so this costs a few register reads.
+	 *		- SECURE_OCM and HDCP_14_22_KEY have no version register. They update
+	 *		  if their HDCP_LOAD_STATUS CRC bits are clear, or if the CRC32 read
+	 *		  back from flash differs from the bundle's.
+	 *		Everything goes again if the journal holds an unfinished update of
+	 *		this bundle. Partitions the bundle doesn't carry are left alone.
+	 *
+	 *		All selected partitions are programmed in one run, sector by sector,
+	 *		with each step recorded in the flash journal, so an update cut short
+	 *		by a reset or power loss picks up at the first sector that was not
+	 *		verified, after re-checking the one before it. Chicago is then power
+	 *		cycled and must pass the boot CRC check of every partition written.
+	 *
+	 *		Blocks until done. Use burn_hex_auto_begin() and burn_hex_auto_step()
+	 *		to run the same update from the application loop instead.
 	 * @ingroup Chicago_flash
 	 * @return uint8_t RETURN_NORMAL_VALUE if success
 	 */		
 	uint8_t burn_hex_auto(void);
+
+	/**
+	 * @brief 
+	 *		Set up a burn_hex_auto() run to be driven by burn_hex_auto_step()
+	 * @ingroup Chicago_flash
+	 * @param pTask - Task state, must stay put until the run finishes
+	 * @return void
+	 */		
+	void burn_hex_auto_begin(tagBurnHexAuto *pTask);
+
+	/**
+	 * @brief 
+	 *		Do the next bounded piece of a burn_hex_auto() run
+	 * @details
+	 *		A step is one BURN_AUTO_CHECK_CHUNK of flash CRC, one 16 byte
+	 *		record (with the block program and read back it completes), one
+	 *		sector erase start or status poll, or one power sequencing action. Delays are waited out
+	 *		across calls, never inside one. Call it from the main loop until it
+	 *		returns BURN_AUTO_DONE or later; pTask->result then holds what
+	 *		burn_hex_auto() would have returned.
+	 * @ingroup Chicago_flash
+	 * @param pTask - Task from burn_hex_auto_begin()
+	 * @return uint8_t - BURN_AUTO_xxx state
+	 */		
+	uint8_t burn_hex_auto_step(tagBurnHexAuto *pTask);
+
+	/**
+	 * @brief 
+	 *		Start a flash programming run
+	 * @details
+	 *		Stops both OCMs, disables write protection and sets the transfer
+	 *		length. Nothing is erased or written until data arrives.
+	 * @ingroup Chicago_flash
+	 * @param pEngine - Engine state to initialize
+	 * @param Flags - FLASH_ENGINE_ERASE and/or FLASH_ENGINE_VERIFY
+	 * @param pJournal - Opened journal to resume from and record progress in, or NULL
+	 * @return void
+	 */	
+	void flash_engine_begin(tagFlashEngine *pEngine, uint8_t Flags, tagFlashJournal *pJournal);
+
+	/**
+	 * @brief 
+	 *		Feed data to a flash programming run
+	 * @details
+	 *		Records may come in any size and alignment. Bytes collect in the
+	 *		current 32 byte block, which is written out when a record lands in
+	 *		another block; bytes no record covered are programmed as 0xFF and
+	 *		left out of the read back.
+	 * @ingroup Chicago_flash
+	 * @param pEngine - Engine from flash_engine_begin()
+	 * @param Address - Flash address of pData[0]
+	 * @param pData - Data
+	 * @param Length - Number of bytes
+	 * @return RETURN_NORMAL_VALUE if success
+	 * @return FLASH_ENGINE_ERR_xxx if a block could not be written
+	 */	
+	int8_t flash_engine_write(tagFlashEngine *pEngine, uint32_t Address, const uint8_t *pData, uint16_t Length);
+
+	/**
+	 * @brief 
+	 *		Program everything a pull source produces
+	 * @ingroup Chicago_flash
+	 * @param pEngine - Engine from flash_engine_begin()
+	 * @param pSource - Source to drain
+	 * @return RETURN_NORMAL_VALUE if the source ran to its end
+	 * @return FLASH_ENGINE_ERR_xxx or the source's own error otherwise
+	 */	
+	int8_t flash_engine_run(tagFlashEngine *pEngine, tagFlashSource *pSource);
+
+	/**
+	 * @brief 
+	 *		Finish a flash programming run
+	 * @details
+	 *		Writes out the last block, re-enables write protection and restores
+	 *		the OCM registers saved by flash_engine_begin().
+	 * @ingroup Chicago_flash
+	 * @param pEngine - Engine from flash_engine_begin()
+	 * @return RETURN_NORMAL_VALUE if every block of the run was good
+	 * @return FLASH_ENGINE_ERR_xxx from the first failure otherwise
+	 */	
+	int8_t flash_engine_end(tagFlashEngine *pEngine);
+
+	/**
+	 * @brief 
+	 *		Check on a sector erase started under FLASH_ENGINE_ASYNC
+	 * @details
+	 *		One status read, no waiting. Feed the engine only once this stops
+	 *		returning FLASH_ENGINE_BUSY, or the next block waits out the erase.
+	 * @ingroup Chicago_flash
+	 * @param pEngine - Engine from flash_engine_begin()
+	 * @return RETURN_NORMAL_VALUE if no erase is running
+	 * @return FLASH_ENGINE_BUSY if the erase is still going
+	 * @return FLASH_ENGINE_ERR_TIMEOUT if it ran past FLASH_TIME_SECTOR_ERASE_MAX
+	 */	
+	int8_t flash_engine_poll(tagFlashEngine *pEngine);
+
+	/**
+	 * @brief 
+	 *		Flash source that produces one partition of the embedded bundle
+	 * @details
+	 *		Covers the whole partition, 0xFF where the image has no data, so
+	 *		every sector gets erased. MAIN_OCM is laid out by
+	 *		burn_hex_auto_offset(), the other partitions are written from their
+	 *		base address on. Set it up with flash_source_ocm_image_open().
+	 * @ingroup Chicago_flash
+	 * @param pContext - tagOcmImageSource
+	 * @param pRecord - Record to fill
+	 * @return 1 if a record was produced, 0 at the end of the partition
+	 */	
+	int8_t flash_source_ocm_image(void *pContext, tagFlashRecord *pRecord);
+
+	/**
+	 * @brief 
+	 *		Point a flash_source_ocm_image() context at one bundle partition
+	 * @ingroup Chicago_flash
+	 * @param pSource - Context to initialize
+	 * @param PartId - MAIN_OCM, SECURE_OCM or HDCP_14_22_KEY
+	 * @return RETURN_NORMAL_VALUE if success
+	 * @return RETURN_FAILURE_VALUE if the bundle has no such partition or it doesn't fit
+	 */	
+	int8_t flash_source_ocm_image_open(tagOcmImageSource *pSource, uint8_t PartId);
+
+	/**
+	 * @brief 
+	 *		Clear g_FlashTiming and start the total timer
+	 * @ingroup Chicago_flash
+	 * @return void
+	 */	
+	void flash_timing_reset(void);
+
+	/**
+	 * @brief 
+	 *		Register the callback that follows a burn
+	 * @details
+	 *		Called at every phase start, every Granularity bytes and when a
+	 *		phase reaches its total. Stays registered for every later burn,
+	 *		whichever way it is started: \burnhex, burn_hex_auto() or a host
+	 *		tool. Runs in the flash loop, keep it short.
+	 * @ingroup Chicago_flash
+	 * @param Callback - NULL to stop reporting
+	 * @param pContext - Passed back to Callback as it is
+	 * @param Granularity - Bytes between callbacks, 0 for FLASH_PROGRESS_GRANULARITY
+	 * @return void
+	 */
+	void flash_progress_set(FlashProgress_t Callback, void *pContext, uint32_t Granularity);
+
+	/**
+	 * @brief 
+	 *		Start a progress phase and report it at 0 bytes
+	 * @ingroup Chicago_flash
+	 * @param Phase - FLASH_PHASE_xxx
+	 * @param Total - Bytes the phase will cover, 0 if not known
+	 * @return void
+	 */
+	void flash_progress_begin(uint8_t Phase, uint32_t Total);
+
+	/**
+	 * @brief 
+	 *		Count bytes towards the current phase
+	 * @details
+	 *		The flash engine calls this for every block it finishes. Cheap
+	 *		unless a callback is due.
+	 * @ingroup Chicago_flash
+	 * @param Bytes - Bytes just finished
+	 * @return void
+	 */
+	void flash_progress_add(uint32_t Bytes);
+
+	/**
+	 * @brief 
+	 *		Print g_FlashTiming from the last burn on the UART console
+	 * @ingroup Chicago_flash
+	 * @note Command line usage: \\flashtime
+	 * @return void
+	 */	
+	void flash_timing_report(void);
 	
 	/**
 	 * @brief 
 	 *		Waits until the flash Write-In-Progress flag is done
+	 * @details
+	 *		Sleeps through the typical time of the operation first, each status
+	 *		read costs three I2C transactions, then polls with doubling
+	 *		intervals.
 	 * @ingroup Chicago_flash
-	 * @return void
+	 * @param Operation - FLASH_OP_xxx that was just started
+	 * @return RETURN_NORMAL_VALUE if success
+	 * @return RETURN_FAILURE_VALUE if WIP was still set after the maximum time
 	 */			
-	static void flash_wait_until_WIP_cleared(void);
+	static int8_t flash_wait_until_WIP_cleared(uint8_t Operation);
 
 	/**
 	 * @brief 
 	 *		Wait until Chicago flash controller hardware state machine returns to idle
 	 * @ingroup Chicago_flash
+	 * @return RETURN_NORMAL_VALUE if success
+	 * @return RETURN_FAILURE_VALUE if it was still busy after FLASH_TIME_SM_MAX
+	 */			
+	static int8_t flash_wait_until_flash_SM_done(void);
+
+	/**
+	 * @brief 
+	 *		Give up the CPU for a while, yielding for anything over a millisecond
+	 * @ingroup Chicago_flash
+	 * @param Microseconds - Time to sleep
+	 * @return void
+	 */			
+	static void flash_sleep_us(uint32_t Microseconds);
+
+	/**
+	 * @brief 
+	 *		Fetch FLASH_READ_MAX_LENGTH bytes from flash with one burst read
+	 * @ingroup Chicago_flash
+	 * @param Address - Flash address
+	 * @param pData - Buffer of FLASH_READ_MAX_LENGTH bytes
+	 * @return RETURN_NORMAL_VALUE if success
+	 * @return RETURN_FAILURE_VALUE if the I2C read failed
+	 */			
+	static int8_t flash_read_block(uint32_t Address, uint8_t *pData);
+
+	/**
+	 * @brief 
+	 *		Erase one 4 KB sector and wait until the flash is idle again
+	 * @ingroup Chicago_flash
+	 * @param Address - Any address inside the sector
+	 * @return RETURN_NORMAL_VALUE if success
+	 * @return RETURN_FAILURE_VALUE if the erase timed out
+	 */			
+	static int8_t flash_erase_sector(uint32_t Address);
+
+	/**
+	 * @brief 
+	 *		Send one \\readbin frame to the UART
+	 * @ingroup Chicago_flash
+	 * @param Type - FLASH_DUMP_TYPE_DATA or FLASH_DUMP_TYPE_END
+	 * @param Address - Flash address of the payload
+	 * @param pData - Payload
+	 * @param Length - Payload length, up to FLASH_DUMP_FRAME_DATA_SIZE
 	 * @return void
 	 */			
-	static void flash_wait_until_flash_SM_done(void);
+	static void flash_dump_frame(uint8_t Type, uint32_t Address, uint8_t *pData, uint16_t Length);
+
+	/**
+	 * @brief 
+	 *		Map a MAIN_OCM flash address to the embedded image offset stored there
+	 * @ingroup Chicago_flash
+	 * @param hex_lines - Number of 16 byte lines in the embedded image
+	 * @param Address - 16-byte aligned flash address
+	 * @return uint32_t - Image offset, HEX_OFFSET_NONE if the address stays blank
+	 */			
+	static uint32_t burn_hex_auto_offset(uint32_t hex_lines, uint32_t Address);
+
+	/**
+	 * @brief 
+	 *		Decide from registers whether one partition of the bundle needs flashing
+	 * @details
+	 *		MAIN_OCM goes by its version and boot CRC bit, the others by their
+	 *		boot CRC bits only; BURN_AUTO_CHECK compares their flash contents.
+	 *		Chicago must be powered on.
+	 * @ingroup Chicago_flash
+	 * @param pPart - Bundle partition
+	 * @param LoadStatus - HDCP_LOAD_STATUS
+	 * @return 1 if the partition is out of date, 0 otherwise
+	 */			
+	static uint8_t burn_hex_auto_needed(const tagOcmPartitionInfo *pPart, uint8_t LoadStatus);
+
+	/**
+	 * @brief 
+	 *		Find the next partition in a PARTITION_ID bit mask
+	 * @ingroup Chicago_flash
+	 * @param Parts - One bit per PARTITION_ID
+	 * @param PartId - First partition to consider
+	 * @return uint8_t - Partition ID, PARTITION_ID_MAX if there are no more
+	 */			
+	static uint8_t burn_hex_auto_next_part(uint8_t Parts, uint8_t PartId);
+
+	/**
+	 * @brief 
+	 *		Open the flash source on the next partition to program, from PartId on
+	 * @ingroup Chicago_flash
+	 * @param pTask - Task from burn_hex_auto_begin()
+	 * @param PartId - First partition to consider
+	 * @return uint8_t - BURN_AUTO_PROGRAM, or BURN_AUTO_FINISH if none are left
+	 */			
+	static uint8_t burn_hex_auto_open_part(tagBurnHexAuto *pTask, uint8_t PartId);
+
+	/**
+	 * @brief 
+	 *		Start BURN_AUTO_CHECK on the next partition to compare, from PartId on
+	 * @ingroup Chicago_flash
+	 * @param pTask - Task from burn_hex_auto_begin()
+	 * @param PartId - First partition to consider
+	 * @return uint8_t - BURN_AUTO_CHECK, or BURN_AUTO_DECIDE if none are left
+	 */			
+	static uint8_t burn_hex_auto_check_part(tagBurnHexAuto *pTask, uint8_t PartId);
+
+	/**
+	 * @brief 
+	 *		Make burn_hex_auto_step() idle for a while before the next state
+	 * @ingroup Chicago_flash
+	 * @param pTask - Task from burn_hex_auto_begin()
+	 * @param Milliseconds - Delay
+	 * @return void
+	 */			
+	static void burn_hex_auto_wait(tagBurnHexAuto *pTask, uint32_t Milliseconds);
+
+	/**
+	 * @brief 
+	 *		Add up the bytes a set of bundle partitions covers, for progress totals
+	 * @ingroup Chicago_flash
+	 * @param Parts - One bit per PARTITION_ID
+	 * @param Padded - 0 for the image sizes, 1 for the whole partitions
+	 * @return uint32_t - Bytes
+	 */			
+	static uint32_t burn_hex_auto_bytes(uint8_t Parts, uint8_t Padded);
+
+	/**
+	 * @brief 
+	 *		Check one console line of a staged \burnhex first transfer
+	 * @details
+	 *		The first bad line is remembered and reported at EOF, the rest
+	 *		of the file is still consumed so it can't land on the command line.
+	 * @ingroup Chicago_flash
+	 * @return void
+	 */			
+	static void burn_hex_stage_line(void);
+
+	/**
+	 * @brief 
+	 *		Check that a record lies inside the staged partitions
+	 * @ingroup Chicago_flash
+	 * @param Address - First byte
+	 * @param ByteCount - Record length, at least 1
+	 * @return 1 if every byte does, 0 otherwise
+	 */			
+	static uint8_t burn_hex_stage_in_range(uint32_t Address, uint8_t ByteCount);
+
+	/**
+	 * @brief 
+	 *		Fold a data record into the staged CRC32 and byte count
+	 * @ingroup Chicago_flash
+	 * @param Address - Record address
+	 * @param pData - Record data
+	 * @param ByteCount - Record length
+	 * @return void
+	 */			
+	static void burn_hex_stage_add(uint32_t Address, const uint8_t *pData, uint8_t ByteCount);
+
+	/**
+	 * @brief 
+	 *		Look up the flash address range of a partition
+	 * @ingroup Chicago_flash
+	 * @param PartId - MAIN_OCM, SECURE_OCM or HDCP_14_22_KEY
+	 * @param pBase - First address
+	 * @param pEnd - Last address
+	 * @return RETURN_NORMAL_VALUE if success
+	 * @return RETURN_FAILURE_VALUE if the partition ID is invalid
+	 */			
+	static int8_t flash_partition_bounds(uint8_t PartId, uint32_t *pBase, uint32_t *pEnd);
+
+	/**
+	 * @brief 
+	 *		Fold a flash range into a CRC32, as crc32_update() would compute it
+	 * @details
+	 *		Stops both OCMs while reading and restores them afterwards.
+	 * @ingroup Chicago_flash
+	 * @param Address - First address, 16-byte aligned
+	 * @param Size - Number of bytes
+	 * @param pCrc - Running CRC32, start from CRC32_INITIAL
+	 * @return RETURN_NORMAL_VALUE if success
+	 * @return RETURN_FAILURE_VALUE if a read failed
+	 */			
+	static int8_t flash_partition_crc32(uint32_t Address, uint32_t Size, uint32_t *pCrc);
+
+	/**
+	 * @brief 
+	 *		Stop the secure and main OCM to avoid buffer access conflicts
+	 * @ingroup Chicago_flash
+	 * @param pRegBak1 - ADDR_HDCP2_CTRL back up
+	 * @param pRegBak2 - OCM_DEBUG_CTRL back up
+	 * @return void
+	 */			
+	static void flash_ocm_stop(uint8_t *pRegBak1, uint8_t *pRegBak2);
+
+	/**
+	 * @brief 
+	 *		Restore the OCM registers saved by flash_ocm_stop()
+	 * @ingroup Chicago_flash
+	 * @param RegBak1 - ADDR_HDCP2_CTRL back up
+	 * @param RegBak2 - OCM_DEBUG_CTRL back up
+	 * @return void
+	 */			
+	static void flash_ocm_restore(uint8_t RegBak1, uint8_t RegBak2);
+
+	/**
+	 * @brief 
+	 *		Write out the engine's current block and check it
+	 * @details
+	 *		Blocks that are all 0xFF are not programmed, NOR flash can't turn a
+	 *		bit back to 1 anyway, but they are still read back when verifying.
+	 * @ingroup Chicago_flash
+	 * @param pEngine - Engine from flash_engine_begin()
+	 * @return RETURN_NORMAL_VALUE if success
+	 * @return FLASH_ENGINE_ERR_xxx if the block is bad
+	 */			
+	static int8_t flash_engine_flush(tagFlashEngine *pEngine);
+
+	/**
+	 * @brief 
+	 *		Wait for, or just check on, a FLASH_ENGINE_ASYNC sector erase
+	 * @details
+	 *		Records the erase in the journal once the flash reports it done.
+	 * @ingroup Chicago_flash
+	 * @param pEngine - Engine from flash_engine_begin()
+	 * @param Wait - 0 to read the status once, 1 to wait it out
+	 * @return RETURN_NORMAL_VALUE if no erase is running any more
+	 * @return FLASH_ENGINE_BUSY if Wait is 0 and the erase is still going
+	 * @return FLASH_ENGINE_ERR_TIMEOUT if it ran past FLASH_TIME_SECTOR_ERASE_MAX
+	 */			
+	static int8_t flash_engine_erase_done(tagFlashEngine *pEngine, uint8_t Wait);
+
+	/**
+	 * @brief 
+	 *		Count the bytes a block mask covers
+	 * @ingroup Chicago_flash
+	 * @param Mask - tagFlashEngine.block_mask
+	 * @return uint8_t - Number of bits set
+	 */			
+	static uint8_t flash_engine_mask_bytes(uint32_t Mask);
+
+	/**
+	 * @brief 
+	 *		Fill in the rates and ETA and call the progress callback
+	 * @ingroup Chicago_flash
+	 * @return void
+	 */			
+	static void flash_progress_report(void);
+
+	/**
+	 * @brief 
+	 *		Decide what to do with a sector the engine is about to write into
+	 * @details
+	 *		A sector the journal marks verified is skipped, or only re-checked
+	 *		if it is the last verified one. Any other sector is erased first
+	 *		when FLASH_ENGINE_ERASE is set.
+	 * @ingroup Chicago_flash
+	 * @param pEngine - Engine from flash_engine_begin()
+	 * @param SectorAddr - Sector base address
+	 * @return RETURN_NORMAL_VALUE if success
+	 * @return FLASH_ENGINE_ERR_TIMEOUT if the erase timed out
+	 */			
+	static int8_t flash_engine_enter_sector(tagFlashEngine *pEngine, uint32_t SectorAddr);
+
+	/**
+	 * @brief 
+	 *		Record the outcome of the current sector in the journal
+	 * @ingroup Chicago_flash
+	 * @param pEngine - Engine from flash_engine_begin()
+	 * @return void
+	 */			
+	static void flash_engine_leave_sector(tagFlashEngine *pEngine);
 
 	/**
 	 * @brief 
@@ -278,25 +1037,15 @@
 	 * @return void
 	 */		
 	static void flash_write_prepare(uint32_t Address, uint8_t offset, uint8_t ByteCount, uint8_t* WriteDataBuf);
-
-	/**
-	 * @brief 
-	 *		Does something...?
-	 * @ingroup Chicago_flash
-	 * @param WriteDataBuf - Unknown, ask Analogix
-	 * @param ReadDataBuf - Unknown, ask Analogix
-	 * @param ByteCount - Unknown, ask Analogix
-	 * @return void
-	 */	
-	static void flash_writedata_keep(uint8_t *WriteDataBuf, uint8_t *ReadDataBuf, uint8_t ByteCount);
 	
 	/**
 	 * @brief 
 	 *		Writes to the flash (actually)
 	 * @ingroup Chicago_flash
-	 * @return void
+	 * @return RETURN_NORMAL_VALUE if success
+	 * @return RETURN_FAILURE_VALUE if the flash stayed busy
 	 */		
-	static void flash_actual_write(void);
+	static int8_t flash_actual_write(void);
 	
 #endif  /* __FLASH_H__ */
 
@@ -0,0 +1,105 @@
+/**
+* @file flashJournal.cpp
+*
+* @brief Chicago flash programming progress journal
+*
+* @copyright
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* @copyright
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* @author Adam Munich
+*/
+
+//#############################################################################
+// Includes
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "./flashJournal.h"
+#include "./flash.h"
+#include "./crc32.h"
+
+#include "../Chicago/chicago_config.h"
+
+// the default storage macros use the Arduino EEPROM library
+#ifdef FLASH_JOURNAL_STORE
+	#include <EEPROM.h>
+#endif
+
+
+//#############################################################################
+// Pre-compiler Definitions
+//-----------------------------------------------------------------------------
+#define FLASH_JOURNAL_CRC_LENGTH		(sizeof(tagFlashJournal) - sizeof(uint32_t))
+#define FLASH_JOURNAL_SECTOR(addr)		(((addr) / FLASH_SECTOR_SIZE) % FLASH_JOURNAL_SECTORS)
+
+
+//#############################################################################
+// Function Definitions
+//-----------------------------------------------------------------------------
+void flash_journal_open(tagFlashJournal *pJournal, uint32_t ImageCrc){
+
+	#ifdef FLASH_JOURNAL_LOAD
+		FLASH_JOURNAL_LOAD(*pJournal);
+
+		if ((pJournal->magic == FLASH_JOURNAL_MAGIC) && (pJournal->image_crc == ImageCrc) &&
+			(pJournal->crc == crc32_update(CRC32_INITIAL, (uint8_t *)pJournal, FLASH_JOURNAL_CRC_LENGTH))){
+			return;
+		}
+	#endif
+
+	memset(pJournal, 0, sizeof(tagFlashJournal));
+	pJournal->magic = FLASH_JOURNAL_MAGIC;
+	pJournal->image_crc = ImageCrc;
+}
+
+//-----------------------------------------------------------------------------
+uint8_t flash_journal_in_progress(tagFlashJournal *pJournal){
+	uint8_t i;
+
+	for (i = 0; i < FLASH_JOURNAL_SECTORS; i++){
+		if (pJournal->sector_state[i] != FLASH_SECTOR_UNTOUCHED){
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+uint8_t flash_journal_state(tagFlashJournal *pJournal, uint32_t Address){
+	return pJournal->sector_state[FLASH_JOURNAL_SECTOR(Address)];
+}
+
+//-----------------------------------------------------------------------------
+void flash_journal_mark(tagFlashJournal *pJournal, uint32_t Address, uint8_t State){
+	pJournal->sector_state[FLASH_JOURNAL_SECTOR(Address)] = State;
+	flash_journal_store(pJournal);
+}
+
+//-----------------------------------------------------------------------------
+void flash_journal_close(tagFlashJournal *pJournal){
+	memset(&pJournal->sector_state[0], FLASH_SECTOR_UNTOUCHED, FLASH_JOURNAL_SECTORS);
+	flash_journal_store(pJournal);
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc flash_journal_store
+static void flash_journal_store(tagFlashJournal *pJournal){
+	pJournal->crc = crc32_update(CRC32_INITIAL, (uint8_t *)pJournal, FLASH_JOURNAL_CRC_LENGTH);
+
+	#ifdef FLASH_JOURNAL_STORE
+		FLASH_JOURNAL_STORE(*pJournal);
+	#endif
+}
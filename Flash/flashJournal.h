@@ -0,0 +1,123 @@
+/**
+* @file flashJournal.h
+*
+* @brief Chicago flash programming progress journal _H
+*
+* @copyright
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* @copyright
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* @author Adam Munich
+*/
+
+/**
+* @details
+*	Records, per 4 KB flash sector, how far an update got, keyed by the CRC32
+*	of the image being written. The journal lives in MCU non-volatile storage
+*	through the FLASH_JOURNAL_LOAD / FLASH_JOURNAL_STORE macros in
+*	chicago_config.h; without them it is kept in RAM only and an interrupted
+*	update starts over.
+*/
+
+#ifndef __FLASHJOURNAL_H__
+	#define __FLASHJOURNAL_H__
+
+	//#############################################################################
+	// Pre-compiler Definitions
+	//-----------------------------------------------------------------------------
+	#define FLASH_JOURNAL_MAGIC				0x4A4C4643UL	// "CFLJ"
+	#define FLASH_JOURNAL_SECTORS			16				// 64 KB of flash
+
+	// sector states, in the order they are reached
+	#define FLASH_SECTOR_UNTOUCHED			0
+	#define FLASH_SECTOR_ERASED				1
+	#define FLASH_SECTOR_PROGRAMMED			2
+	#define FLASH_SECTOR_VERIFIED			3
+
+
+	//#############################################################################
+	// Type Definitions
+	//-----------------------------------------------------------------------------
+	typedef struct
+	{
+		uint32_t magic;
+		uint32_t image_crc;		// CRC32 of the image the states belong to
+		uint8_t  sector_state[FLASH_JOURNAL_SECTORS];
+		uint32_t crc;			// CRC32 of the fields above
+	} tagFlashJournal;
+
+
+	//#############################################################################
+	// Function Prototypes
+	//-----------------------------------------------------------------------------
+	/**
+	 * @brief 
+	 *		Load the journal for an image
+	 * @details
+	 *		A missing or corrupt journal, or one written for a different image,
+	 *		reads back with every sector FLASH_SECTOR_UNTOUCHED.
+	 * @ingroup Chicago_flash
+	 * @param pJournal - Journal to fill
+	 * @param ImageCrc - CRC32 of the image about to be programmed
+	 * @return void
+	 */
+	void flash_journal_open(tagFlashJournal *pJournal, uint32_t ImageCrc);
+
+	/**
+	 * @brief 
+	 *		Tells whether an earlier update of this image was interrupted
+	 * @ingroup Chicago_flash
+	 * @param pJournal - Journal from flash_journal_open()
+	 * @return uint8_t - 1 if any sector has left FLASH_SECTOR_UNTOUCHED
+	 */
+	uint8_t flash_journal_in_progress(tagFlashJournal *pJournal);
+
+	/**
+	 * @brief 
+	 *		Returns the recorded state of the sector holding Address
+	 * @ingroup Chicago_flash
+	 * @param pJournal - Journal from flash_journal_open()
+	 * @param Address - Any flash address inside the sector
+	 * @return uint8_t - FLASH_SECTOR_xxx
+	 */
+	uint8_t flash_journal_state(tagFlashJournal *pJournal, uint32_t Address);
+
+	/**
+	 * @brief 
+	 *		Record a new state for the sector holding Address and store the journal
+	 * @ingroup Chicago_flash
+	 * @param pJournal - Journal from flash_journal_open()
+	 * @param Address - Any flash address inside the sector
+	 * @param State - FLASH_SECTOR_xxx
+	 * @return void
+	 */
+	void flash_journal_mark(tagFlashJournal *pJournal, uint32_t Address, uint8_t State);
+
+	/**
+	 * @brief 
+	 *		Forget all progress once an update has completed
+	 * @ingroup Chicago_flash
+	 * @param pJournal - Journal from flash_journal_open()
+	 * @return void
+	 */
+	void flash_journal_close(tagFlashJournal *pJournal);
+
+	/**
+	 * @brief 
+	 *		Recompute the journal CRC and write it to non-volatile storage
+	 * @ingroup Chicago_flash
+	 * @param pJournal - Journal to store
+	 * @return void
+	 */
+	static void flash_journal_store(tagFlashJournal *pJournal);
+
+#endif  /* __FLASHJOURNAL_H__ */
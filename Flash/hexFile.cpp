@@ -28,6 +28,7 @@
 #include <string.h>
 
 #include "./hexFile.h"
+#include "./ocmImage.h"
 
 #include "../Debug/debug.h"
 #include "../Chicago/chicago_config.h"
@@ -43,16 +44,6 @@
 #define HEX_RECORD_TYPE_SIZE		2
 #define HEX_ONE_DATA_SIZE			2
 
-#define VERSION_ADDR				0x0100
-
-
-//#############################################################################
-// Variable Declarations
-//-----------------------------------------------------------------------------
-uint8_t const OCM_FW_DATA[]= {
-	#include "ocm_hex.h"
-};
-
 
 //#############################################################################
 // Function Definitions
@@ -134,11 +125,8 @@ void read_hex_ver(uint8_t *pData){
 		TRACE1("read_hex_ver(uint8_t *pData=%x)\n", pData);
 	#endif
 
-	pData[0] = OCM_FW_DATA[VERSION_ADDR];		// main version
-	pData[1] = OCM_FW_DATA[VERSION_ADDR + 1] ;	// minor version
-	pData[2] = OCM_FW_DATA[VERSION_ADDR + 2] ;	// build version
-	pData[0] = pData[0]&0x0F;
-	pData[1] = pData[1]&0x0F;
+	// main, minor, build version, taken from the image at build time
+	ocm_image_version(pData);
 	
 	#ifdef DEBUG_LEVEL_2
 		TRACE3("\tOCM version: %01X.%01X.%02X \n", pData[0], pData[1], pData[2]);
@@ -147,7 +135,7 @@ void read_hex_ver(uint8_t *pData){
 
 //-----------------------------------------------------------------------------
 uint32_t get_hex_size(void){
-	return(sizeof(OCM_FW_DATA));
+	return(ocm_image_size());
 }
 
 //-----------------------------------------------------------------------------
@@ -0,0 +1,229 @@
+/**
+* @file ocmImage.cpp
+*
+* @brief Chicago embedded OCM firmware image (compressed)
+*
+* @copyright
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* @copyright
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* @author Adam Munich
+*/
+
+//#############################################################################
+// Includes
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdint.h>
+
+#include "./ocmImage.h"
+#include "./crc32.h"
+#include "./flash.h"
+
+#include "../Chicago/chicago_config.h"
+
+
+//#############################################################################
+// Pre-compiler Definitions
+//-----------------------------------------------------------------------------
+#define OCM_IMAGE_WINDOW_MASK		(OCM_IMAGE_WINDOW_SIZE - 1)
+
+
+//#############################################################################
+// Variable Declarations
+//-----------------------------------------------------------------------------
+// The one and only copy of the OCM firmware in MCU flash, generated by Host/ocm_pack.cpp
+static uint8_t const OCM_FW_PACK[] = {
+	#include "ocm_pack.h"
+};
+
+// OCM_INFO_xxx of the same image, also generated by Host/ocm_pack.cpp
+#include "ocm_info.h"
+
+static const tagOcmPartitionInfo OCM_PARTITIONS[] = {
+	OCM_INFO_PARTITIONS
+};
+
+#define OCM_PARTITION_COUNT			(sizeof(OCM_PARTITIONS) / sizeof(OCM_PARTITIONS[0]))
+
+
+//#############################################################################
+// Function Definitions
+//-----------------------------------------------------------------------------
+int8_t ocm_image_open(tagOcmImageStream *pStream){
+	return ocm_image_open_partition(pStream, MAIN_OCM);
+}
+
+//-----------------------------------------------------------------------------
+int8_t ocm_image_open_partition(tagOcmImageStream *pStream, uint8_t PartId){
+	const tagOcmPartitionInfo *pPart;
+	const uint8_t *pHeader;
+
+	pPart = ocm_image_partition(PartId);
+	if ((pPart == NULL) || (pPart->pack_offset + OCM_IMAGE_HEADER_SIZE > sizeof(OCM_FW_PACK))){
+		return RETURN_FAILURE_VALUE;
+	}
+
+	pHeader = &OCM_FW_PACK[pPart->pack_offset];
+	if ((pHeader[0] != OCM_IMAGE_MAGIC_0) || (pHeader[1] != OCM_IMAGE_MAGIC_1) ||
+		(pHeader[2] != OCM_IMAGE_FORMAT_VERSION)){
+		return RETURN_FAILURE_VALUE;
+	}
+
+	pStream->src_index	= pPart->pack_offset + OCM_IMAGE_HEADER_SIZE;
+	pStream->out_index	= 0;
+	pStream->token		= 0;
+	pStream->remaining	= 0;
+	pStream->distance	= 0;
+	pStream->window_pos	= 0;
+	pStream->image_size	= ((uint32_t)pHeader[3]) | ((uint32_t)pHeader[4] << 8) |
+		((uint32_t)pHeader[5] << 16) | ((uint32_t)pHeader[6] << 24);
+
+	return RETURN_NORMAL_VALUE;
+}
+
+//-----------------------------------------------------------------------------
+const tagOcmPartitionInfo *ocm_image_partition(uint8_t PartId){
+	uint8_t i;
+
+	for (i = 0; i < OCM_PARTITION_COUNT; i++){
+		if (OCM_PARTITIONS[i].id == PartId){
+			return &OCM_PARTITIONS[i];
+		}
+	}
+
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------
+uint16_t ocm_image_read(tagOcmImageStream *pStream, uint8_t *pData, uint16_t Length){
+	return (uint16_t)ocm_image_unpack(pStream, pData, Length);
+}
+
+//-----------------------------------------------------------------------------
+uint32_t ocm_image_skip(tagOcmImageStream *pStream, uint32_t Length){
+	return ocm_image_unpack(pStream, NULL, Length);
+}
+
+//-----------------------------------------------------------------------------
+uint32_t ocm_image_size(void){
+	if ((OCM_FW_PACK[0] != OCM_IMAGE_MAGIC_0) || (OCM_FW_PACK[1] != OCM_IMAGE_MAGIC_1)){
+		return 0;
+	}
+
+	return ((uint32_t)OCM_FW_PACK[3]) | ((uint32_t)OCM_FW_PACK[4] << 8) |
+		((uint32_t)OCM_FW_PACK[5] << 16) | ((uint32_t)OCM_FW_PACK[6] << 24);
+}
+
+//-----------------------------------------------------------------------------
+uint32_t ocm_image_packed_size(void){
+	return(sizeof(OCM_FW_PACK));
+}
+
+//-----------------------------------------------------------------------------
+uint32_t ocm_image_crc32(void){
+	return OCM_INFO_CRC32;
+}
+
+//-----------------------------------------------------------------------------
+void ocm_image_version(uint8_t *pVersion){
+	pVersion[0] = OCM_INFO_VERSION_MAJOR;
+	pVersion[1] = OCM_INFO_VERSION_MINOR;
+	pVersion[2] = OCM_INFO_VERSION_BUILD;
+}
+
+//-----------------------------------------------------------------------------
+int8_t ocm_image_check(void){
+	tagOcmImageStream OcmImage;
+	uint8_t buf[32];
+	uint16_t n;
+	uint32_t crc;
+	uint8_t i;
+
+	for (i = 0; i < OCM_PARTITION_COUNT; i++){
+		if ((ocm_image_open_partition(&OcmImage, OCM_PARTITIONS[i].id) != RETURN_NORMAL_VALUE) ||
+			(OcmImage.image_size != OCM_PARTITIONS[i].size)){
+			return RETURN_FAILURE_VALUE;
+		}
+
+		crc = CRC32_INITIAL;
+		while ((n = ocm_image_read(&OcmImage, &buf[0], sizeof(buf))) != 0){
+			crc = crc32_update(crc, &buf[0], n);
+		}
+
+		if (crc != OCM_PARTITIONS[i].crc32){
+			return RETURN_FAILURE_VALUE;
+		}
+	}
+
+	return RETURN_NORMAL_VALUE;
+}
+
+//-----------------------------------------------------------------------------
+/// @copydoc ocm_image_unpack
+static uint32_t ocm_image_unpack(tagOcmImageStream *pStream, uint8_t *pData, uint32_t Length){
+	uint32_t image_size;
+	uint32_t count;
+	uint8_t  c;
+
+	image_size = pStream->image_size;
+	count = 0;
+
+	while ((count < Length) && (pStream->out_index < image_size)){
+
+		// fetch the next token
+		if (pStream->remaining == 0){
+			if (pStream->src_index + 1 >= sizeof(OCM_FW_PACK)){
+				break;  // truncated image
+			}
+
+			pStream->token = OCM_FW_PACK[pStream->src_index++];
+
+			if (pStream->token < OCM_IMAGE_TOKEN_FILL){
+				pStream->remaining = (uint16_t)pStream->token + 1;
+			}
+			else if (pStream->token < OCM_IMAGE_TOKEN_MATCH){
+				pStream->remaining = ((((uint16_t)pStream->token & 0x3F) << 8) | OCM_FW_PACK[pStream->src_index++]) + 1;
+			}
+			else{
+				pStream->remaining = ((uint16_t)pStream->token & 0x3F) + OCM_IMAGE_MATCH_MIN;
+				pStream->distance = OCM_FW_PACK[pStream->src_index++];
+			}
+		}
+
+		if (pStream->token < OCM_IMAGE_TOKEN_FILL){
+			if (pStream->src_index >= sizeof(OCM_FW_PACK)){
+				break;  // truncated image
+			}
+			c = OCM_FW_PACK[pStream->src_index++];
+		}
+		else if (pStream->token < OCM_IMAGE_TOKEN_MATCH){
+			c = 0xFF;
+		}
+		else{
+			c = pStream->window[(pStream->window_pos - pStream->distance - 1) & OCM_IMAGE_WINDOW_MASK];
+		}
+
+		pStream->window[pStream->window_pos] = c;
+		pStream->window_pos = (pStream->window_pos + 1) & OCM_IMAGE_WINDOW_MASK;
+
+		if (pData != NULL){
+			*pData++ = c;
+		}
+
+		pStream->remaining--;
+		pStream->out_index++;
+		count++;
+	}
+
+	return count;
+}
@@ -0,0 +1,225 @@
+/**
+* @file ocmImage.h
+*
+* @brief Chicago embedded OCM firmware image (compressed) _H
+*
+* @copyright
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* @copyright
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* @author Adam Munich
+*/
+
+/**
+* @details
+*	The OCM firmware is no longer linked in raw. Host/ocm_pack.cpp turns the
+*	Analogix ocm_hex.h byte list into ocm_pack.h, which holds the image in the
+*	packed form below, and this module streams it back out a few bytes at a
+*	time. The packer also writes ocm_info.h, the image size, CRC32 and
+*	version worked out at build time. Re-run it whenever ocm_hex.h is updated:
+*
+*		g++ -o ocm_pack Host/ocm_pack.cpp Flash/crc32.cpp
+*		./ocm_pack Flash/ocm_hex.h Flash/ocm_pack.h Flash/ocm_info.h
+*
+*	The secure OCM firmware and the HDCP keys can ride along in the same
+*	bundle, each as its own packed stream placed after the main one:
+*
+*		./ocm_pack -s secure_hex.h -k hdcp_key_hex.h Flash/ocm_hex.h \
+*			Flash/ocm_pack.h Flash/ocm_info.h
+*
+*	Packed stream layout:
+*		[0..1]	magic 'O' 'Z'
+*		[2]		format version
+*		[3..6]	unpacked image size, little endian
+*		[7..]	tokens, until the unpacked size has been produced
+*
+*	Tokens (c = token byte):
+*		0x00..0x7F	literal: (c + 1) bytes follow, copied as they are
+*		0x80..0xBF	0xFF run: (((c & 0x3F) << 8) | next byte) + 1 bytes of 0xFF
+*		0xC0..0xFF	match: (c & 0x3F) + 3 bytes copied from (next byte + 1)
+*					bytes back in the output
+*/
+
+#ifndef __OCMIMAGE_H__
+	#define __OCMIMAGE_H__
+
+	//#############################################################################
+	// Pre-compiler Definitions
+	//-----------------------------------------------------------------------------
+	#define OCM_IMAGE_MAGIC_0				'O'
+	#define OCM_IMAGE_MAGIC_1				'Z'
+	#define OCM_IMAGE_FORMAT_VERSION		1
+	#define OCM_IMAGE_HEADER_SIZE			7
+
+	// main, minor, build version bytes inside the unpacked image
+	#define OCM_IMAGE_VERSION_OFFSET		0x0100
+
+	#define OCM_IMAGE_LITERAL_MAX			128
+	#define OCM_IMAGE_FILL_MAX				16384
+	#define OCM_IMAGE_MATCH_MIN				3
+	#define OCM_IMAGE_MATCH_MAX				66
+
+	// Back-reference window, also the decoder's only RAM buffer
+	#define OCM_IMAGE_WINDOW_SIZE			256
+
+	#define OCM_IMAGE_TOKEN_FILL			0x80
+	#define OCM_IMAGE_TOKEN_MATCH			0xC0
+
+
+	//#############################################################################
+	// Type Definitions
+	//-----------------------------------------------------------------------------
+	typedef struct
+	{
+		uint32_t src_index;			// next packed byte to consume
+		uint32_t out_index;			// unpacked bytes produced so far
+		uint8_t  token;				// token being expanded
+		uint16_t remaining;			// bytes left in the current token
+		uint8_t  distance;			// match distance - 1
+		uint8_t  window_pos;		// wraps at OCM_IMAGE_WINDOW_SIZE
+		uint32_t image_size;		// unpacked size of this partition's stream
+		uint8_t  window[OCM_IMAGE_WINDOW_SIZE];
+	} tagOcmImageStream;
+
+	// One partition of the bundle, from OCM_INFO_PARTITIONS in ocm_info.h
+	typedef struct
+	{
+		uint8_t  id;				// MAIN_OCM, SECURE_OCM or HDCP_14_22_KEY
+		uint32_t pack_offset;		// start of its packed stream, header included
+		uint32_t size;				// unpacked size
+		uint32_t crc32;				// CRC32 of the unpacked data
+		uint8_t  version[3];		// main, minor, build; 0.0.00 for key data
+	} tagOcmPartitionInfo;
+
+
+	//#############################################################################
+	// Function Prototypes
+	//-----------------------------------------------------------------------------
+	/**
+	 * @brief
+	 *		Rewind an image stream to the first byte of the OCM firmware
+	 * @ingroup Chicago_flash
+	 * @param pStream - Stream state to initialize
+	 * @return RETURN_NORMAL_VALUE if success
+	 * @return RETURN_FAILURE_VALUE if the packed image header is bad
+	 */
+	int8_t ocm_image_open(tagOcmImageStream *pStream);
+
+	/**
+	 * @brief
+	 *		Rewind an image stream to the first byte of one bundle partition
+	 * @ingroup Chicago_flash
+	 * @param pStream - Stream state to initialize
+	 * @param PartId - MAIN_OCM, SECURE_OCM or HDCP_14_22_KEY
+	 * @return RETURN_NORMAL_VALUE if success
+	 * @return RETURN_FAILURE_VALUE if the bundle has no such partition or its header is bad
+	 */
+	int8_t ocm_image_open_partition(tagOcmImageStream *pStream, uint8_t PartId);
+
+	/**
+	 * @brief
+	 *		Look up one partition of the bundle
+	 * @ingroup Chicago_flash
+	 * @param PartId - MAIN_OCM, SECURE_OCM or HDCP_14_22_KEY
+	 * @return const tagOcmPartitionInfo* - NULL if the bundle doesn't carry it
+	 */
+	const tagOcmPartitionInfo *ocm_image_partition(uint8_t PartId);
+
+	/**
+	 * @brief
+	 *		Unpack the next bytes of the OCM firmware
+	 * @ingroup Chicago_flash
+	 * @param pStream - Stream opened by ocm_image_open()
+	 * @param pData - Destination buffer
+	 * @param Length - Number of bytes wanted
+	 * @return uint16_t - Number of bytes written to pData, less than Length
+	 *		only at the end of the image
+	 */
+	uint16_t ocm_image_read(tagOcmImageStream *pStream, uint8_t *pData, uint16_t Length);
+
+	/**
+	 * @brief
+	 *		Skip forward in the OCM firmware without keeping the data
+	 * @ingroup Chicago_flash
+	 * @param pStream - Stream opened by ocm_image_open()
+	 * @param Length - Number of bytes to skip
+	 * @return uint32_t - Number of bytes skipped
+	 */
+	uint32_t ocm_image_skip(tagOcmImageStream *pStream, uint32_t Length);
+
+	/**
+	 * @brief
+	 *		Returns the unpacked size of the OCM firmware
+	 * @ingroup Chicago_flash
+	 * @return uint32_t - Size in bytes, 0 if the packed image header is bad
+	 */
+	uint32_t ocm_image_size(void);
+
+	/**
+	 * @brief
+	 *		Returns the size of the packed OCM firmware as stored in MCU flash
+	 * @ingroup Chicago_flash
+	 * @return uint32_t - Size in bytes
+	 */
+	uint32_t ocm_image_packed_size(void);
+
+	/**
+	 * @brief
+	 *		Returns the CRC32 of the unpacked OCM firmware
+	 * @details
+	 *		Computed by Host/ocm_pack.cpp, nothing is unpacked at run time.
+	 * @ingroup Chicago_flash
+	 * @return uint32_t - CRC32 as computed by crc32_update()
+	 */
+	uint32_t ocm_image_crc32(void);
+
+	/**
+	 * @brief
+	 *		Returns the main, minor and build version of the OCM firmware
+	 * @details
+	 *		Read at build time from OCM_IMAGE_VERSION_OFFSET, major and minor
+	 *		already masked to a nibble.
+	 * @ingroup Chicago_flash
+	 * @param pVersion - 3 bytes
+	 * @return void
+	 */
+	void ocm_image_version(uint8_t *pVersion);
+
+	/**
+	 * @brief
+	 *		Unpack every partition of the bundle and check it against the build
+	 *		time CRC32
+	 * @details
+	 *		Catches an ocm_pack.h and ocm_info.h from different packer runs, or
+	 *		a damaged MCU flash. Unpacks everything, so only call it once an
+	 *		update has been decided on.
+	 * @ingroup Chicago_flash
+	 * @return RETURN_NORMAL_VALUE if every partition unpacks to its CRC32
+	 * @return RETURN_FAILURE_VALUE otherwise
+	 */
+	int8_t ocm_image_check(void);
+
+	/**
+	 * @brief
+	 *		Expand packed tokens into the caller's buffer
+	 * @details
+	 *		The window is updated whether or not the bytes are kept, so that
+	 *		later matches still resolve after a skip.
+	 * @ingroup Chicago_flash
+	 * @param pStream - Stream opened by ocm_image_open()
+	 * @param pData - Destination buffer, NULL to discard the bytes
+	 * @param Length - Number of bytes wanted
+	 * @return uint32_t - Number of bytes produced
+	 */
+	static uint32_t ocm_image_unpack(tagOcmImageStream *pStream, uint8_t *pData, uint32_t Length);
+
+#endif  /* __OCMIMAGE_H__ */
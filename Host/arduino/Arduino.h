@@ -0,0 +1,68 @@
+/**
+* @file Arduino.h
+*
+* @brief Just enough of the Arduino core to build the Chicago flash code on Linux _H
+*
+* @copyright
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* @copyright
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* @author Adam Munich
+*/
+
+/**
+* @details
+*	Only for Host/ tools, put Host/arduino on the include path (-IHost/arduino)
+*	so that the library's own #include <Arduino.h> lands here. Serial goes to
+*	stdout, time comes from CLOCK_MONOTONIC.
+*/
+
+#ifndef __HOST_ARDUINO_H__
+	#define __HOST_ARDUINO_H__
+
+	//#############################################################################
+	// Includes
+	//-----------------------------------------------------------------------------
+	#include <stdint.h>
+	#include <stddef.h>
+	#include <stdio.h>
+	#include <string.h>
+
+
+	//#############################################################################
+	// Type Definitions
+	//-----------------------------------------------------------------------------
+	class HostSerial
+	{
+		public:
+			int printf(const char *pFormat, ...);
+			size_t write(const uint8_t *pData, size_t Length);
+			size_t write(uint8_t Data);
+			void flush(void);
+	};
+
+
+	//#############################################################################
+	// Variable Declarations
+	//-----------------------------------------------------------------------------
+	extern HostSerial Serial;
+
+
+	//#############################################################################
+	// Function Prototypes
+	//-----------------------------------------------------------------------------
+	unsigned long micros(void);
+	unsigned long millis(void);
+	void delay(unsigned long Milliseconds);
+	void delayMicroseconds(unsigned int Microseconds);
+
+#endif  /* __HOST_ARDUINO_H__ */
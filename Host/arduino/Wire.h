@@ -0,0 +1,78 @@
+/**
+* @file Wire.h
+*
+* @brief Arduino Wire on top of a Host/host_i2c.h bus _H
+*
+* @copyright
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* @copyright
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* @author Adam Munich
+*/
+
+/**
+* @details
+*	Queues a transmission the way the Arduino library does and hands it to
+*	host_i2c_transfer() at endTransmission(). endTransmission(false) keeps the
+*	write pending so the following requestFrom() goes out as one combined
+*	write/read with a repeated start, as I2C/i2c.cpp expects.
+*/
+
+#ifndef __HOST_WIRE_H__
+	#define __HOST_WIRE_H__
+
+	//#############################################################################
+	// Includes
+	//-----------------------------------------------------------------------------
+	#include <stdint.h>
+	#include <stddef.h>
+
+
+	//#############################################################################
+	// Pre-compiler Definitions
+	//-----------------------------------------------------------------------------
+	// same as the Teensy Wire library, so the host hits the same limits
+	#define WIRE_BUFFER_LENGTH				32
+
+
+	//#############################################################################
+	// Type Definitions
+	//-----------------------------------------------------------------------------
+	class TwoWire
+	{
+		public:
+			void begin(void);
+			void beginTransmission(uint8_t Address);
+			size_t write(uint8_t Data);
+			size_t write(const uint8_t *pData, size_t Length);
+			uint8_t endTransmission(uint8_t SendStop = 1);
+			uint8_t requestFrom(uint8_t Address, uint8_t Quantity);
+			int available(void);
+			int read(void);
+
+		private:
+			uint8_t tx_address;
+			uint8_t tx_length;
+			uint8_t tx_pending;			// endTransmission(false), waiting for requestFrom()
+			uint8_t tx_buffer[WIRE_BUFFER_LENGTH];
+			uint8_t rx_length;
+			uint8_t rx_index;
+			uint8_t rx_buffer[WIRE_BUFFER_LENGTH];
+	};
+
+
+	//#############################################################################
+	// Variable Declarations
+	//-----------------------------------------------------------------------------
+	extern TwoWire Wire;
+
+#endif  /* __HOST_WIRE_H__ */
@@ -0,0 +1,189 @@
+/**
+* @file host_arduino.cpp
+*
+* @brief Just enough of the Arduino core to build the Chicago flash code on Linux
+*
+* @copyright
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* @copyright
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* @author Adam Munich
+*/
+
+#ifndef ARDUINO
+
+//#############################################################################
+// Includes
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "./Arduino.h"
+#include "./Wire.h"
+
+#include "../host_i2c.h"
+
+
+//#############################################################################
+// Variable Declarations
+//-----------------------------------------------------------------------------
+HostSerial Serial;
+TwoWire Wire;
+
+
+//#############################################################################
+// Function Definitions
+//-----------------------------------------------------------------------------
+static uint64_t host_clock_us(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+//-----------------------------------------------------------------------------
+unsigned long micros(void){
+	return (unsigned long)host_clock_us();
+}
+
+//-----------------------------------------------------------------------------
+unsigned long millis(void){
+	return (unsigned long)(host_clock_us() / 1000);
+}
+
+//-----------------------------------------------------------------------------
+void delay(unsigned long Milliseconds){
+	delayMicroseconds(Milliseconds * 1000);
+}
+
+//-----------------------------------------------------------------------------
+void delayMicroseconds(unsigned int Microseconds){
+	struct timespec ts;
+
+	ts.tv_sec = Microseconds / 1000000;
+	ts.tv_nsec = (long)(Microseconds % 1000000) * 1000;
+	nanosleep(&ts, NULL);
+}
+
+//-----------------------------------------------------------------------------
+int HostSerial::printf(const char *pFormat, ...){
+	va_list args;
+	int n;
+
+	va_start(args, pFormat);
+	n = vprintf(pFormat, args);
+	va_end(args);
+
+	return n;
+}
+
+//-----------------------------------------------------------------------------
+size_t HostSerial::write(const uint8_t *pData, size_t Length){
+	return fwrite(pData, 1, Length, stdout);
+}
+
+//-----------------------------------------------------------------------------
+size_t HostSerial::write(uint8_t Data){
+	return (putchar(Data) == EOF) ? 0 : 1;
+}
+
+//-----------------------------------------------------------------------------
+void HostSerial::flush(void){
+	fflush(stdout);
+}
+
+//-----------------------------------------------------------------------------
+void TwoWire::begin(void){
+	tx_length = 0;
+	tx_pending = 0;
+	rx_length = 0;
+	rx_index = 0;
+}
+
+//-----------------------------------------------------------------------------
+void TwoWire::beginTransmission(uint8_t Address){
+	tx_address = Address;
+	tx_length = 0;
+	tx_pending = 0;
+}
+
+//-----------------------------------------------------------------------------
+size_t TwoWire::write(uint8_t Data){
+	if (tx_length >= WIRE_BUFFER_LENGTH){
+		return 0;
+	}
+
+	tx_buffer[tx_length++] = Data;
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+size_t TwoWire::write(const uint8_t *pData, size_t Length){
+	size_t i;
+
+	for (i = 0; i < Length; i++){
+		if (write(pData[i]) == 0){
+			break;
+		}
+	}
+
+	return i;
+}
+
+//-----------------------------------------------------------------------------
+uint8_t TwoWire::endTransmission(uint8_t SendStop){
+	if (!SendStop){
+		tx_pending = 1;
+		return 0;
+	}
+
+	tx_pending = 0;
+
+	// 2 = address NACK, as close as i2c-dev gets to telling us
+	return (host_i2c_transfer(tx_address, &tx_buffer[0], tx_length, NULL, 0) == 0) ? 0 : 2;
+}
+
+//-----------------------------------------------------------------------------
+uint8_t TwoWire::requestFrom(uint8_t Address, uint8_t Quantity){
+	int result;
+
+	if (Quantity > WIRE_BUFFER_LENGTH){
+		Quantity = WIRE_BUFFER_LENGTH;
+	}
+
+	if (tx_pending && (tx_address == Address)){
+		result = host_i2c_transfer(Address, &tx_buffer[0], tx_length, &rx_buffer[0], Quantity);
+	}
+	else{
+		result = host_i2c_transfer(Address, NULL, 0, &rx_buffer[0], Quantity);
+	}
+
+	tx_pending = 0;
+	rx_index = 0;
+	rx_length = (result == 0) ? Quantity : 0;
+
+	return rx_length;
+}
+
+//-----------------------------------------------------------------------------
+int TwoWire::available(void){
+	return rx_length - rx_index;
+}
+
+//-----------------------------------------------------------------------------
+int TwoWire::read(void){
+	return (rx_index < rx_length) ? rx_buffer[rx_index++] : -1;
+}
+
+#endif  /* ARDUINO */
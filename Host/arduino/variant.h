@@ -0,0 +1,25 @@
+/**
+* @file variant.h
+*
+* @brief Empty stand-in for the Teensy variant header on Linux _H
+*
+* @copyright
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* @copyright
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* @author Adam Munich
+*/
+
+#ifndef __HOST_VARIANT_H__
+	#define __HOST_VARIANT_H__
+
+#endif  /* __HOST_VARIANT_H__ */
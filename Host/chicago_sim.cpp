@@ -0,0 +1,205 @@
+/**
+* @file chicago_sim.cpp
+*
+* @brief Simulated Chicago register and flash model for the Host/ tools
+*
+* @copyright
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* @copyright
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* @author Adam Munich
+*/
+
+#ifndef ARDUINO
+
+//#############################################################################
+// Includes
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "./chicago_sim.h"
+
+#include "../Chicago/chicago_config.h"
+#include "../Chicago/chicago.h"
+#include "../Chicago/chicago_registers.h"
+
+
+//#############################################################################
+// Pre-compiler Definitions
+//-----------------------------------------------------------------------------
+#define SIM_PAGE_SPI					(SLAVEID_SPI)
+#define SIM_BP_MASK						(BP4 | BP3 | BP2 | BP1 | BP0)
+
+// flash length register holds length - 1
+#define SIM_FLASH_ADDR(pSim)			(((uint32_t)(pSim)->regs[SIM_PAGE_SPI][R_FLASH_ADDR_H] << 8) | (pSim)->regs[SIM_PAGE_SPI][R_FLASH_ADDR_L])
+#define SIM_FLASH_LEN(pSim)				((((uint32_t)(pSim)->regs[SIM_PAGE_SPI][R_FLASH_LEN_H] << 8) | (pSim)->regs[SIM_PAGE_SPI][R_FLASH_LEN_L]) + 1)
+
+
+//#############################################################################
+// Function Definitions
+//-----------------------------------------------------------------------------
+static void chicago_sim_erase(tagChicagoSim *pSim, uint32_t Address, uint32_t Size){
+	memset(&pSim->flash[Address & ~(Size - 1) & (CHICAGO_SIM_FLASH_SIZE - 1)], 0xFF, Size);
+	pSim->erases++;
+}
+
+//-----------------------------------------------------------------------------
+// A write to R_FLASH_RW_CTRL starts the flash controller, which finishes at once
+static void chicago_sim_flash_ctrl(tagChicagoSim *pSim, uint8_t Ctrl){
+	uint8_t *pRegs = &pSim->regs[SIM_PAGE_SPI][0];
+	uint32_t address;
+	uint32_t length;
+	uint32_t i;
+	uint8_t  hw_protected;
+	uint8_t  writable;
+
+	address = SIM_FLASH_ADDR(pSim);
+	length = SIM_FLASH_LEN(pSim);
+
+	// WP# low and SRP0 set locks the status register
+	hw_protected = ((pRegs[GPIO_STATUS_1] & FLASH_WP) == 0) && (pSim->status & SRP0);
+	writable = pSim->write_enable && ((pSim->status & SIM_BP_MASK) == 0);
+
+	if (Ctrl & GENERAL_INSTRUCTION_EN){
+		switch (pRegs[R_FLASH_STATUS_2]){
+			case WRITE_ENABLE:
+				pSim->write_enable = 1;
+				return;
+			case WRITE_DISABLE:
+				break;
+			case CHIP_ERASE_A:
+			case CHIP_ERASE_B:
+				if (writable){
+					chicago_sim_erase(pSim, 0, CHICAGO_SIM_FLASH_SIZE);
+				}
+				break;
+			default:
+				break;
+		}
+	}
+	else if (Ctrl & WRITE_STATUS_EN){
+		if (pSim->write_enable && !hw_protected){
+			pSim->status = pRegs[R_FLASH_STATUS_0] & ~WIP;
+		}
+	}
+	else if (Ctrl & FLASH_ERASE_EN){
+		if (writable){
+			switch (pRegs[R_FLASH_STATUS_3]){
+				case SECTOR_ERASE:		chicago_sim_erase(pSim, address, 0x1000);	break;
+				case BLOCK_ERASE_32K:	chicago_sim_erase(pSim, address, 0x8000);	break;
+				case BLOCK_ERASE_64K:	chicago_sim_erase(pSim, address, 0x10000);	break;
+				default:				break;
+			}
+		}
+	}
+	else if (Ctrl & FLASH_WRITE){
+		if (writable){
+			for (i = 0; (i < length) && (R_FLASH_ADDR_0 + i < 0x100); i++){
+				if (((address + i) & (CHICAGO_SIM_FLASH_SIZE - 1)) != pSim->stuck_address){
+					pSim->flash[(address + i) & (CHICAGO_SIM_FLASH_SIZE - 1)] &= pRegs[R_FLASH_ADDR_0 + i];
+				}
+			}
+			pSim->programs++;
+		}
+	}
+	else if (Ctrl & FLASH_READ){
+		for (i = 0; (i < length) && (FLASH_READ_D0 + i < 0x100); i++){
+			pRegs[FLASH_READ_D0 + i] = pSim->flash[(address + i) & (CHICAGO_SIM_FLASH_SIZE - 1)];
+		}
+		return;
+	}
+	else{
+		return;
+	}
+
+	// every command but WRITE_ENABLE and reads clears the latch
+	pSim->write_enable = 0;
+}
+
+//-----------------------------------------------------------------------------
+static void chicago_sim_write(tagChicagoSim *pSim, uint8_t Offset, uint8_t Data){
+	pSim->regs[pSim->page][Offset] = Data;
+
+	if ((pSim->page == SIM_PAGE_SPI) && (Offset == R_FLASH_RW_CTRL)){
+		chicago_sim_flash_ctrl(pSim, Data);
+		pSim->regs[SIM_PAGE_SPI][R_FLASH_RW_CTRL] = 0;
+	}
+}
+
+//-----------------------------------------------------------------------------
+static uint8_t chicago_sim_read(tagChicagoSim *pSim, uint8_t Offset){
+	if (pSim->page == SIM_PAGE_SPI){
+		switch (Offset){
+			case R_RAM_CTRL:		return pSim->regs[SIM_PAGE_SPI][Offset] | FLASH_DONE;
+			case R_FLASH_STATUS_4:	return pSim->status;
+			default:				break;
+		}
+	}
+
+	return pSim->regs[pSim->page][Offset];
+}
+
+//-----------------------------------------------------------------------------
+static int chicago_sim_transfer(void *pContext, uint8_t Address, const uint8_t *pWrite, size_t WriteLength, uint8_t *pRead, size_t ReadLength){
+	tagChicagoSim *pSim = (tagChicagoSim *)pContext;
+	uint8_t offset;
+	size_t i;
+
+	// page select: offset 0x00, then slave ID | offset bits 11..8
+	if (Address == (CHICAGO_SLAVEID_ADDR >> 1)){
+		if ((WriteLength == 2) && (pWrite[0] == 0x00) && (ReadLength == 0)){
+			pSim->page = pWrite[1];
+			return 0;
+		}
+		return -1;
+	}
+
+	if (Address != (CHICAGO_OFFSET_ADDR >> 1)){
+		return -1;  // nobody home
+	}
+
+	if (WriteLength == 0){
+		return -1;
+	}
+
+	// registers auto-increment from the offset byte
+	offset = pWrite[0];
+	for (i = 1; i < WriteLength; i++){
+		chicago_sim_write(pSim, offset++, pWrite[i]);
+	}
+	for (i = 0; i < ReadLength; i++){
+		pRead[i] = chicago_sim_read(pSim, offset++);
+	}
+
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+void chicago_sim_init(tagChicagoSim *pSim){
+	memset(pSim, 0, sizeof(*pSim));
+	memset(&pSim->flash[0], 0xFF, sizeof(pSim->flash));
+
+	pSim->status = SRP0 | SIM_BP_MASK;
+	pSim->stuck_address = CHICAGO_SIM_NO_FAULT;
+
+	pSim->regs[SIM_PAGE_SPI][HDCP_LOAD_STATUS] = OCM_FW_CRC32 | HDCP_22_FW_CRC32 | HDCP_22_KEY_CRC32 | HDCP_14_KEY_CRC32;
+}
+
+//-----------------------------------------------------------------------------
+void chicago_sim_bus(tagChicagoSim *pSim, tagHostI2cBus *pBus){
+	pBus->transfer = chicago_sim_transfer;
+	pBus->pContext = pSim;
+}
+
+#endif  /* ARDUINO */
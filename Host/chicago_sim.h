@@ -0,0 +1,88 @@
+/**
+* @file chicago_sim.h
+*
+* @brief Simulated Chicago register and flash model for the Host/ tools _H
+*
+* @copyright
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* @copyright
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* @author Adam Munich
+*/
+
+/**
+* @details
+*	Models what Flash/flash.cpp talks to: the two I2C addresses with the page
+*	select, the SPI flash controller registers in SLAVEID_SPI, the flash
+*	status register with its write enable latch and block protection, and
+*	64 KB of NOR flash that can only be programmed from 1 to 0. The flash is
+*	never busy and the OCMs are not modelled beyond their registers.
+*
+*	stuck_address makes one flash byte ignore programming, to check that a
+*	verify failure is caught and reported.
+*/
+
+#ifndef __CHICAGO_SIM_H__
+	#define __CHICAGO_SIM_H__
+
+	//#############################################################################
+	// Includes
+	//-----------------------------------------------------------------------------
+	#include <stdint.h>
+
+	#include "./host_i2c.h"
+
+
+	//#############################################################################
+	// Pre-compiler Definitions
+	//-----------------------------------------------------------------------------
+	#define CHICAGO_SIM_FLASH_SIZE			0x10000
+	#define CHICAGO_SIM_NO_FAULT			0xFFFFFFFFUL
+
+
+	//#############################################################################
+	// Type Definitions
+	//-----------------------------------------------------------------------------
+	typedef struct
+	{
+		uint8_t  flash[CHICAGO_SIM_FLASH_SIZE];
+		uint8_t  regs[256][256];		// [page][offset], page = slave ID | offset bits 11..8
+		uint8_t  page;					// last page select
+		uint8_t  status;				// flash status register
+		uint8_t  write_enable;			// flash write enable latch
+		uint32_t stuck_address;			// flash byte that can't be programmed, or CHICAGO_SIM_NO_FAULT
+		uint32_t programs;				// page programs, sector/chip erases done
+		uint32_t erases;
+	} tagChicagoSim;
+
+
+	//#############################################################################
+	// Function Prototypes
+	//-----------------------------------------------------------------------------
+	/**
+	 * @brief 
+	 *		Reset the model: flash blank and write protected, boot CRC checks passed
+	 * @param pSim - Model state
+	 * @return void
+	 */
+	void chicago_sim_init(tagChicagoSim *pSim);
+
+	/**
+	 * @brief 
+	 *		Make an I2C bus that talks to the model
+	 * @param pSim - Model state, must outlive the bus
+	 * @param pBus - Bus to fill in
+	 * @return void
+	 */
+	void chicago_sim_bus(tagChicagoSim *pSim, tagHostI2cBus *pBus);
+
+#endif  /* __CHICAGO_SIM_H__ */
@@ -0,0 +1,259 @@
+/**
+* @file flash_dump.cpp
+*
+* @brief Host-side receiver for the \readbin flash read-out
+*
+* @copyright
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* @copyright
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* @author Adam Munich
+*/
+
+/**
+* @details
+*	Sends \readbin to the debug console, collects the CRC32 framed reply and
+*	saves it as raw binary or Intel HEX, chosen by the output file extension.
+*	This file is not part of the Arduino build.
+*
+*		g++ -o flash_dump Host/flash_dump.cpp Host/host_serial.cpp Flash/crc32.cpp
+*		./flash_dump /dev/ttyACM0 0 10000 rma.bin [baud]
+*
+*	Exit status is 0 only if every frame and the whole-dump CRC check out.
+*/
+
+#ifndef ARDUINO
+
+//#############################################################################
+// Includes
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "./host_serial.h"
+
+#include "../Flash/crc32.h"
+#include "../Flash/flash.h"
+
+
+//#############################################################################
+// Pre-compiler Definitions
+//-----------------------------------------------------------------------------
+#define DUMP_TIMEOUT_MS				3000
+#define DUMP_DEFAULT_BAUD			115200
+
+
+//#############################################################################
+// Function Definitions
+//-----------------------------------------------------------------------------
+static uint32_t get_le32(const uint8_t *p){
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+//-----------------------------------------------------------------------------
+static double now_seconds(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+//-----------------------------------------------------------------------------
+// Hunt for SYNC0 SYNC1, skipping the console echo and text around the frames
+static int wait_for_sync(int Fd){
+	uint8_t c;
+	uint8_t prev;
+
+	prev = 0;
+	while (host_serial_read(Fd, &c, 1, DUMP_TIMEOUT_MS) == 1){
+		if ((prev == FLASH_DUMP_SYNC0) && (c == FLASH_DUMP_SYNC1)){
+			return 0;
+		}
+		prev = c;
+	}
+
+	return -1;
+}
+
+//-----------------------------------------------------------------------------
+static int receive_dump(int Fd, uint32_t Base, std::vector<uint8_t> &Image, uint32_t *pReceived){
+	uint8_t frame[FLASH_DUMP_HEADER_SIZE + FLASH_DUMP_FRAME_DATA_SIZE + 4];
+	uint32_t address;
+	uint32_t crc;
+	uint32_t total_crc;
+	uint16_t length;
+
+	total_crc = CRC32_INITIAL;
+	*pReceived = 0;
+
+	while (1){
+		if (wait_for_sync(Fd) != 0){
+			fprintf(stderr, "timeout waiting for frame\n");
+			return -1;
+		}
+
+		// type, address, length
+		if (host_serial_read(Fd, &frame[2], FLASH_DUMP_HEADER_SIZE - 2, DUMP_TIMEOUT_MS) != FLASH_DUMP_HEADER_SIZE - 2){
+			fprintf(stderr, "truncated frame header\n");
+			return -1;
+		}
+
+		address = get_le32(&frame[3]);
+		length = (uint16_t)(frame[7] | (frame[8] << 8));
+		if (length > FLASH_DUMP_FRAME_DATA_SIZE){
+			// a false sync inside the text, keep hunting
+			continue;
+		}
+
+		if (host_serial_read(Fd, &frame[FLASH_DUMP_HEADER_SIZE], length + 4, DUMP_TIMEOUT_MS) != length + 4){
+			fprintf(stderr, "truncated frame at 0x%04X\n", address);
+			return -1;
+		}
+
+		crc = crc32_update(CRC32_INITIAL, &frame[2], FLASH_DUMP_HEADER_SIZE - 2 + length);
+		if (crc != get_le32(&frame[FLASH_DUMP_HEADER_SIZE + length])){
+			fprintf(stderr, "CRC error in frame at 0x%04X\n", address);
+			return -1;
+		}
+
+		if (frame[2] == FLASH_DUMP_TYPE_END){
+			if ((length != 4) || (get_le32(&frame[FLASH_DUMP_HEADER_SIZE]) != total_crc)){
+				fprintf(stderr, "whole-dump CRC mismatch\n");
+				return -1;
+			}
+			return 0;
+		}
+
+		if ((frame[2] != FLASH_DUMP_TYPE_DATA) || (address < Base) || (address - Base + length > Image.size())){
+			fprintf(stderr, "unexpected frame at 0x%04X\n", address);
+			return -1;
+		}
+
+		memcpy(&Image[address - Base], &frame[FLASH_DUMP_HEADER_SIZE], length);
+		total_crc = crc32_update(total_crc, &frame[FLASH_DUMP_HEADER_SIZE], length);
+		*pReceived += length;
+
+		fprintf(stderr, "\r%u / %u bytes", *pReceived, (uint32_t)Image.size());
+	}
+}
+
+//-----------------------------------------------------------------------------
+static int write_hex(FILE *fp, uint32_t Base, const std::vector<uint8_t> &Image){
+	uint32_t address;
+	uint32_t upper;
+	uint8_t count;
+	uint8_t checksum;
+	uint8_t i;
+
+	upper = 0;
+	for (address = Base; address < Base + Image.size(); address += count){
+		if ((address >> 16) != upper){
+			upper = address >> 16;
+			checksum = (uint8_t)(2 + 4 + (upper >> 8) + upper);
+			fprintf(fp, ":02000004%04X%02X\n", upper, (uint8_t)-checksum);
+		}
+
+		count = (Base + Image.size() - address > 16) ? 16 : (uint8_t)(Base + Image.size() - address);
+		checksum = count + (uint8_t)(address >> 8) + (uint8_t)address;
+		fprintf(fp, ":%02X%04X00", count, address & 0xFFFF);
+		for (i = 0; i < count; i++){
+			fprintf(fp, "%02X", Image[address - Base + i]);
+			checksum += Image[address - Base + i];
+		}
+		fprintf(fp, "%02X\n", (uint8_t)-checksum);
+	}
+
+	fprintf(fp, ":00000001FF\n");
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, char **argv){
+	std::vector<uint8_t> image;
+	char command[64];
+	uint32_t base;
+	uint32_t size;
+	uint32_t received;
+	uint32_t baud;
+	double start;
+	double elapsed;
+	const char *ext;
+	FILE *fp;
+	int fd;
+	int ret;
+
+	if ((argc != 5) && (argc != 6)){
+		fprintf(stderr, "usage: %s <tty> <hex_base_address> <hex_size> <out.bin|out.hex> [baud]\n", argv[0]);
+		return 2;
+	}
+
+	base = (uint32_t)strtoul(argv[2], NULL, 16);
+	size = (uint32_t)strtoul(argv[3], NULL, 16);
+	baud = (argc == 6) ? (uint32_t)strtoul(argv[5], NULL, 10) : DUMP_DEFAULT_BAUD;
+	if (size == 0){
+		fprintf(stderr, "nothing to read\n");
+		return 2;
+	}
+
+	fd = host_serial_open(argv[1], baud);
+	if (fd < 0){
+		perror(argv[1]);
+		return 2;
+	}
+
+	image.assign(size, 0xFF);
+	host_serial_flush(fd);
+
+	snprintf(command, sizeof(command), "\\readbin %x %x", base, size);
+	start = now_seconds();
+	host_serial_command(fd, command);
+
+	ret = receive_dump(fd, base, image, &received);
+	elapsed = now_seconds() - start;
+	close(fd);
+
+	fprintf(stderr, "\n%u bytes in %.2f s (%.1f KB/s)\n", received, elapsed, (elapsed > 0) ? received / elapsed / 1024.0 : 0.0);
+
+	if (ret != 0){
+		return 1;
+	}
+	if (received != size){
+		fprintf(stderr, "short read: %u of %u bytes, I2C error on the target?\n", received, size);
+		return 1;
+	}
+
+	fp = fopen(argv[4], "wb");
+	if (fp == NULL){
+		perror(argv[4]);
+		return 2;
+	}
+
+	ext = strrchr(argv[4], '.');
+	if ((ext != NULL) && (strcasecmp(ext, ".hex") == 0)){
+		write_hex(fp, base, image);
+	}
+	else{
+		fwrite(&image[0], 1, image.size(), fp);
+	}
+	fclose(fp);
+
+	return 0;
+}
+
+#endif  /* ARDUINO */
@@ -0,0 +1,408 @@
+/**
+* @file flash_i2c.cpp
+*
+* @brief Host-side (Linux) Chicago flash programmer over i2c-dev
+*
+* @copyright
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* @copyright
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* @author Adam Munich
+*/
+
+/**
+* @details
+*	Programs and verifies the Chicago flash straight from a Linux test
+*	station, no MCU console in between. The flash work is done by the same
+*	Flash/flash.cpp engine and I2C/i2c.cpp the firmware runs, built against
+*	Host/arduino and a Host/host_i2c.h bus. Like the firmware build it needs
+*	Flash/ocm_pack.h and Flash/ocm_info.h from Host/ocm_pack.cpp.
+*
+*		g++ -IHost/arduino -o flash_i2c Host/flash_i2c.cpp Host/host_i2c.cpp \
+*			Host/chicago_sim.cpp Host/arduino/host_arduino.cpp Flash/flash.cpp \
+*			Flash/hexFile.cpp Flash/ocmImage.cpp Flash/flashJournal.cpp \
+*			Flash/crc32.cpp I2C/i2c.cpp
+*		./flash_i2c /dev/i2c-1 ocm.hex
+*		./flash_i2c -b 1000 -e main sim:flash.bin ocm.bin
+*
+*	"sim" in place of the device runs against Host/chicago_sim.h instead;
+*	"sim:file" loads the simulated flash from file and saves it back after.
+*
+*	Exit status is 0 if every block was programmed and read back correctly,
+*	1 on a verify mismatch or flash error, 2 on bad arguments or input.
+*/
+
+#ifndef ARDUINO
+
+//#############################################################################
+// Includes
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <Arduino.h>
+
+#include "./host_i2c.h"
+#include "./chicago_sim.h"
+
+#include "../Flash/flash.h"
+#include "../Flash/hexFile.h"
+#include "../Chicago/chicago_config.h"
+#include "../Chicago/chicago.h"
+
+
+//#############################################################################
+// Pre-compiler Definitions
+//-----------------------------------------------------------------------------
+#define FLASHER_LINE_SIZE				600		// 255 data bytes as hex, and then some
+#define FLASHER_PROGRESS_BYTES			1024
+
+#define FLASHER_EXIT_OK					0
+#define FLASHER_EXIT_FLASH				1
+#define FLASHER_EXIT_USAGE				2
+
+
+//#############################################################################
+// Type Definitions
+//-----------------------------------------------------------------------------
+typedef struct
+{
+	uint32_t address;
+	std::vector<uint8_t> data;
+} tagFlasherRecord;
+
+
+//#############################################################################
+// Variable Declarations
+//-----------------------------------------------------------------------------
+// owned by Debug/cmdHandler.cpp in the firmware
+tagFlashRWinfo g_FlashRWinfo;
+uint8_t g_bFlashWrite = 0;
+uint8_t g_bFlashResult = 0;
+uint8_t g_CmdLineBuf[CMD_LINE_SIZE];
+
+extern tagFlashTiming g_FlashTiming;
+
+static tagChicagoSim g_Sim;
+
+
+//#############################################################################
+// Function Definitions
+//-----------------------------------------------------------------------------
+// The test station owns Chicago's power and reset, nothing to switch here
+char chicago_power_onoff(uint8_t onoff){
+	(void)onoff;
+	return RETURN_NORMAL_VALUE;
+}
+
+//-----------------------------------------------------------------------------
+char chicago_power_supply(uint8_t onoff){
+	(void)onoff;
+	return RETURN_NORMAL_VALUE;
+}
+
+//-----------------------------------------------------------------------------
+static double now_seconds(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+//-----------------------------------------------------------------------------
+static int load_hex(FILE *fp, std::vector<tagFlasherRecord> &Records){
+	char line[FLASHER_LINE_SIZE];
+	uint8_t data[256];
+	uint8_t byte_count;
+	uint8_t record_type;
+	uint32_t address;
+	uint32_t line_number;
+	tagFlasherRecord record;
+
+	line_number = 0;
+	while (fgets(line, sizeof(line), fp) != NULL){
+		line_number++;
+		line[strcspn(line, "\r\n")] = '\0';
+		if (line[0] == '\0'){
+			continue;
+		}
+
+		if (GetLineData((uint8_t *)line, &byte_count, &address, &record_type, &data[0]) != RETURN_NORMAL_VALUE){
+			fprintf(stderr, "line %u: bad or unsupported HEX record\n", line_number);
+			return -1;
+		}
+
+		if (record_type == HEX_RECORD_TYPE_EOF){
+			return 0;
+		}
+
+		record.address = address;
+		record.data.assign(&data[0], &data[byte_count]);
+		Records.push_back(record);
+	}
+
+	fprintf(stderr, "no EOF record\n");
+	return -1;
+}
+
+//-----------------------------------------------------------------------------
+static int load_bin(FILE *fp, uint32_t Base, std::vector<tagFlasherRecord> &Records){
+	uint8_t data[FLASH_WRITE_MAX_LENGTH];
+	tagFlasherRecord record;
+	size_t n;
+
+	record.address = Base;
+	while ((n = fread(&data[0], 1, sizeof(data), fp)) != 0){
+		record.data.assign(&data[0], &data[n]);
+		Records.push_back(record);
+		record.address += n;
+	}
+
+	return ferror(fp) ? -1 : 0;
+}
+
+//-----------------------------------------------------------------------------
+static int load_image(const char *pPath, uint32_t Base, std::vector<tagFlasherRecord> &Records){
+	const char *ext;
+	FILE *fp;
+	int ret;
+
+	fp = fopen(pPath, "rb");
+	if (fp == NULL){
+		perror(pPath);
+		return -1;
+	}
+
+	ext = strrchr(pPath, '.');
+	if ((ext != NULL) && (strcasecmp(ext, ".hex") == 0)){
+		ret = load_hex(fp, Records);
+	}
+	else{
+		ret = load_bin(fp, Base, Records);
+	}
+	fclose(fp);
+
+	// the flash is 64 KB, anything past it is a bad base or a bad file
+	for (size_t i = 0; (ret == 0) && (i < Records.size()); i++){
+		if (Records[i].address + Records[i].data.size() > CHICAGO_SIM_FLASH_SIZE){
+			fprintf(stderr, "%s: data at 0x%X is past the end of flash\n", pPath, Records[i].address);
+			ret = -1;
+		}
+	}
+
+	return ret;
+}
+
+//-----------------------------------------------------------------------------
+static int parse_partition(const char *pName){
+	if (strcmp(pName, "main") == 0){
+		return MAIN_OCM;
+	}
+	if (strcmp(pName, "secure") == 0){
+		return SECURE_OCM;
+	}
+	if (strcmp(pName, "key") == 0){
+		return HDCP_14_22_KEY;
+	}
+
+	return -1;
+}
+
+//-----------------------------------------------------------------------------
+// flash_progress_set() callback, stdout carries the engine's TRACE output
+static void show_progress(const tagFlashProgress *pProgress, void *pContext){
+	(void)pContext;
+
+	fflush(stdout);
+	fprintf(stderr, "\r%u / %u bytes, %.1f KB/s (now %.1f)", pProgress->bytes_done, pProgress->bytes_total,
+		pProgress->avg_bps / 1024.0, pProgress->rate_bps / 1024.0);
+	if (pProgress->eta_ms != FLASH_PROGRESS_ETA_UNKNOWN){
+		fprintf(stderr, ", %u.%u s left", pProgress->eta_ms / 1000, (pProgress->eta_ms % 1000) / 100);
+	}
+	fprintf(stderr, "   ");
+}
+
+//-----------------------------------------------------------------------------
+static void usage(const char *pName){
+	fprintf(stderr, "usage: %s [-b hex_base] [-e main|secure|key]... [-n] [-f hex_addr] <i2c-dev|sim[:flash.bin]> <image.hex|image.bin>\n", pName);
+	fprintf(stderr, "  -b  load address of a .bin image (default 0)\n");
+	fprintf(stderr, "  -e  erase a whole partition first, may be repeated\n");
+	fprintf(stderr, "  -n  don't erase the sectors being written, they are blank already\n");
+	fprintf(stderr, "  -f  sim only: flash byte that ignores programming\n");
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, char **argv){
+	std::vector<tagFlasherRecord> records;
+	std::vector<uint8_t> partitions;
+	tagHostI2cBus bus;
+	tagFlashEngine engine;
+	const char *device;
+	const char *sim_file;
+	uint32_t base;
+	uint32_t stuck;
+	uint32_t total;
+	uint8_t flags;
+	int8_t return_code;
+	double start;
+	double elapsed;
+	FILE *fp;
+	int part;
+	int opt;
+	size_t i;
+
+	base = 0;
+	stuck = CHICAGO_SIM_NO_FAULT;
+	flags = FLASH_ENGINE_ERASE | FLASH_ENGINE_VERIFY;
+
+	while ((opt = getopt(argc, argv, "b:e:nf:")) != -1){
+		switch (opt){
+			case 'b':
+				base = (uint32_t)strtoul(optarg, NULL, 16);
+				break;
+			case 'e':
+				part = parse_partition(optarg);
+				if (part < 0){
+					usage(argv[0]);
+					return FLASHER_EXIT_USAGE;
+				}
+				partitions.push_back((uint8_t)part);
+				break;
+			case 'n':
+				flags &= ~FLASH_ENGINE_ERASE;
+				break;
+			case 'f':
+				stuck = (uint32_t)strtoul(optarg, NULL, 16);
+				break;
+			default:
+				usage(argv[0]);
+				return FLASHER_EXIT_USAGE;
+		}
+	}
+
+	if (argc - optind != 2){
+		usage(argv[0]);
+		return FLASHER_EXIT_USAGE;
+	}
+	device = argv[optind];
+
+	if (load_image(argv[optind + 1], base, records) != 0){
+		return FLASHER_EXIT_USAGE;
+	}
+
+	total = 0;
+	for (i = 0; i < records.size(); i++){
+		total += records[i].data.size();
+	}
+
+	// bus: the simulated chip or a real adapter
+	sim_file = NULL;
+	if (strncmp(device, "sim", 3) == 0){
+		chicago_sim_init(&g_Sim);
+		g_Sim.stuck_address = stuck;
+
+		if (device[3] == ':'){
+			sim_file = &device[4];
+			fp = fopen(sim_file, "rb");
+			if (fp != NULL){
+				if (fread(&g_Sim.flash[0], 1, sizeof(g_Sim.flash), fp) == 0){
+					fprintf(stderr, "%s: empty, starting blank\n", sim_file);
+				}
+				fclose(fp);
+			}
+		}
+
+		chicago_sim_bus(&g_Sim, &bus);
+	}
+	else{
+		if (stuck != CHICAGO_SIM_NO_FAULT){
+			fprintf(stderr, "-f only works with the simulated chip\n");
+			return FLASHER_EXIT_USAGE;
+		}
+		if (host_i2c_open(device, &bus) != 0){
+			perror(device);
+			return FLASHER_EXIT_USAGE;
+		}
+	}
+	host_i2c_attach(&bus);
+
+	flash_timing_reset();
+	g_FlashRWinfo.total_bytes_written = 0;
+	start = now_seconds();
+
+	for (i = 0; i < partitions.size(); i++){
+		command_erase_partition(partitions[i]);
+	}
+
+	flash_progress_set(show_progress, NULL, FLASHER_PROGRESS_BYTES);
+	flash_progress_begin(FLASH_PHASE_PROGRAM, total);
+	flash_engine_begin(&engine, flags, NULL);
+
+	return_code = RETURN_NORMAL_VALUE;
+	for (i = 0; (i < records.size()) && (return_code == RETURN_NORMAL_VALUE); i++){
+		return_code = flash_engine_write(&engine, records[i].address, &records[i].data[0], (uint16_t)records[i].data.size());
+	}
+
+	if (flash_engine_end(&engine) != RETURN_NORMAL_VALUE){
+		return_code = engine.status;
+	}
+	g_FlashTiming.total_us = TIMESTAMP_US() - g_FlashTiming.start_us;
+
+	elapsed = now_seconds() - start;
+	fprintf(stderr, "\n");
+
+	flash_timing_report();
+	fflush(stdout);
+
+	fprintf(stderr, "%lu bytes programmed in %.2f s (%.1f KB/s), %u I2C transfers\n",
+		g_FlashRWinfo.total_bytes_written, elapsed,
+		(elapsed > 0) ? g_FlashRWinfo.total_bytes_written / elapsed / 1024.0 : 0.0,
+		host_i2c_transfers());
+
+	if (sim_file != NULL){
+		fp = fopen(sim_file, "wb");
+		if ((fp == NULL) || (fwrite(&g_Sim.flash[0], 1, sizeof(g_Sim.flash), fp) != sizeof(g_Sim.flash))){
+			perror(sim_file);
+		}
+		if (fp != NULL){
+			fclose(fp);
+		}
+	}
+	else if (strncmp(device, "sim", 3) != 0){
+		host_i2c_close(&bus);
+	}
+
+	switch (return_code){
+		case RETURN_NORMAL_VALUE:
+			fprintf(stderr, "verify OK\n");
+			return FLASHER_EXIT_OK;
+		case FLASH_ENGINE_ERR_VERIFY:
+			fprintf(stderr, "VERIFY MISMATCH in sector 0x%04X\n", engine.sector_addr);
+			return FLASHER_EXIT_FLASH;
+		case FLASH_ENGINE_ERR_TIMEOUT:
+			fprintf(stderr, "flash timed out in sector 0x%04X\n", engine.sector_addr);
+			return FLASHER_EXIT_FLASH;
+		default:
+			fprintf(stderr, "flash error %d in sector 0x%04X\n", return_code, engine.sector_addr);
+			return FLASHER_EXIT_FLASH;
+	}
+}
+
+#endif  /* ARDUINO */
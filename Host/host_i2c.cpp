@@ -0,0 +1,137 @@
+/**
+* @file host_i2c.cpp
+*
+* @brief Host-side (Linux) I2C bus for the Chicago flash code
+*
+* @copyright
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* @copyright
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* @author Adam Munich
+*/
+
+#ifndef ARDUINO
+
+//#############################################################################
+// Includes
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#include "./host_i2c.h"
+
+
+//#############################################################################
+// Variable Declarations
+//-----------------------------------------------------------------------------
+static tagHostI2cBus g_HostI2cBus;
+static uint32_t g_HostI2cTransfers;
+
+
+//#############################################################################
+// Function Definitions
+//-----------------------------------------------------------------------------
+// Write, then read after a repeated start, in one I2C_RDWR so nothing else
+// gets onto the bus in between
+static int host_i2c_dev_transfer(void *pContext, uint8_t Address, const uint8_t *pWrite, size_t WriteLength, uint8_t *pRead, size_t ReadLength){
+	struct i2c_msg msgs[2];
+	struct i2c_rdwr_ioctl_data set;
+	int fd;
+
+	fd = (int)(intptr_t)pContext;
+	set.msgs = &msgs[0];
+	set.nmsgs = 0;
+
+	if (WriteLength != 0){
+		msgs[set.nmsgs].addr = Address;
+		msgs[set.nmsgs].flags = 0;
+		msgs[set.nmsgs].len = (uint16_t)WriteLength;
+		msgs[set.nmsgs].buf = (uint8_t *)pWrite;
+		set.nmsgs++;
+	}
+
+	if (ReadLength != 0){
+		msgs[set.nmsgs].addr = Address;
+		msgs[set.nmsgs].flags = I2C_M_RD;
+		msgs[set.nmsgs].len = (uint16_t)ReadLength;
+		msgs[set.nmsgs].buf = pRead;
+		set.nmsgs++;
+	}
+
+	if (set.nmsgs == 0){
+		return 0;
+	}
+
+	return (ioctl(fd, I2C_RDWR, &set) == (int)set.nmsgs) ? 0 : -1;
+}
+
+//-----------------------------------------------------------------------------
+int host_i2c_open(const char *pPath, tagHostI2cBus *pBus){
+	unsigned long funcs;
+	int fd;
+
+	fd = open(pPath, O_RDWR);
+	if (fd < 0){
+		return -1;
+	}
+
+	// repeated start reads need plain I2C, SMBus-only adapters won't do
+	if ((ioctl(fd, I2C_FUNCS, &funcs) < 0) || ((funcs & I2C_FUNC_I2C) == 0)){
+		close(fd);
+		errno = EOPNOTSUPP;
+		return -1;
+	}
+
+	pBus->transfer = host_i2c_dev_transfer;
+	pBus->pContext = (void *)(intptr_t)fd;
+
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+void host_i2c_close(tagHostI2cBus *pBus){
+	if (pBus->transfer == host_i2c_dev_transfer){
+		close((int)(intptr_t)pBus->pContext);
+	}
+
+	pBus->transfer = NULL;
+}
+
+//-----------------------------------------------------------------------------
+void host_i2c_attach(const tagHostI2cBus *pBus){
+	g_HostI2cBus = *pBus;
+	g_HostI2cTransfers = 0;
+}
+
+//-----------------------------------------------------------------------------
+int host_i2c_transfer(uint8_t Address, const uint8_t *pWrite, size_t WriteLength, uint8_t *pRead, size_t ReadLength){
+	if (g_HostI2cBus.transfer == NULL){
+		return -1;
+	}
+
+	g_HostI2cTransfers++;
+	return g_HostI2cBus.transfer(g_HostI2cBus.pContext, Address, pWrite, WriteLength, pRead, ReadLength);
+}
+
+//-----------------------------------------------------------------------------
+uint32_t host_i2c_transfers(void){
+	return g_HostI2cTransfers;
+}
+
+#endif  /* ARDUINO */
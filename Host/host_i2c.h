@@ -0,0 +1,111 @@
+/**
+* @file host_i2c.h
+*
+* @brief Host-side (Linux) I2C bus for the Chicago flash code _H
+*
+* @copyright
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* @copyright
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* @author Adam Munich
+*/
+
+/**
+* @details
+*	A bus is one transfer function: an optional write, then an optional read
+*	after a repeated start. host_i2c_open() makes one on a Linux i2c-dev
+*	adapter, Host/chicago_sim.h makes one on the simulated chip.
+*	host_i2c_attach() routes the Host/arduino Wire object, and with it all
+*	of I2C/i2c.cpp, to that bus.
+*/
+
+#ifndef __HOST_I2C_H__
+	#define __HOST_I2C_H__
+
+	//#############################################################################
+	// Includes
+	//-----------------------------------------------------------------------------
+	#include <stdint.h>
+	#include <stddef.h>
+
+
+	//#############################################################################
+	// Type Definitions
+	//-----------------------------------------------------------------------------
+	/**
+	 * @brief 
+	 *		One I2C transaction
+	 * @param pContext - tagHostI2cBus.pContext
+	 * @param Address - 7 bit device address
+	 * @param pWrite - Bytes to write, NULL if WriteLength is 0
+	 * @param WriteLength - Number of bytes to write
+	 * @param pRead - Buffer for the bytes read back, NULL if ReadLength is 0
+	 * @param ReadLength - Number of bytes to read
+	 * @return int - 0 if the device acknowledged everything, negative otherwise
+	 */
+	typedef int (*HostI2cTransfer_t)(void *pContext, uint8_t Address, const uint8_t *pWrite, size_t WriteLength, uint8_t *pRead, size_t ReadLength);
+
+	typedef struct
+	{
+		HostI2cTransfer_t transfer;
+		void *pContext;
+	} tagHostI2cBus;
+
+
+	//#############################################################################
+	// Function Prototypes
+	//-----------------------------------------------------------------------------
+	/**
+	 * @brief 
+	 *		Open a Linux i2c-dev adapter
+	 * @param pPath - Device path, e.g. /dev/i2c-1
+	 * @param pBus - Bus to fill in
+	 * @return int - 0 if success, negative on error (errno is set)
+	 */
+	int host_i2c_open(const char *pPath, tagHostI2cBus *pBus);
+
+	/**
+	 * @brief 
+	 *		Close a bus from host_i2c_open()
+	 * @param pBus - Bus to close
+	 * @return void
+	 */
+	void host_i2c_close(tagHostI2cBus *pBus);
+
+	/**
+	 * @brief 
+	 *		Send all Wire traffic to a bus
+	 * @param pBus - Bus to use, copied
+	 * @return void
+	 */
+	void host_i2c_attach(const tagHostI2cBus *pBus);
+
+	/**
+	 * @brief 
+	 *		Run one transaction on the attached bus
+	 * @param Address - 7 bit device address
+	 * @param pWrite - Bytes to write, NULL if WriteLength is 0
+	 * @param WriteLength - Number of bytes to write
+	 * @param pRead - Buffer for the bytes read back, NULL if ReadLength is 0
+	 * @param ReadLength - Number of bytes to read
+	 * @return int - 0 if success, negative on error or if no bus is attached
+	 */
+	int host_i2c_transfer(uint8_t Address, const uint8_t *pWrite, size_t WriteLength, uint8_t *pRead, size_t ReadLength);
+
+	/**
+	 * @brief 
+	 *		Number of transactions run on the attached bus so far
+	 * @return uint32_t
+	 */
+	uint32_t host_i2c_transfers(void);
+
+#endif  /* __HOST_I2C_H__ */
@@ -0,0 +1,153 @@
+/**
+* @file host_serial.cpp
+*
+* @brief Host-side (Linux) serial port helpers for the Chicago debug console
+*
+* @copyright
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* @copyright
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* @author Adam Munich
+*/
+
+#ifndef ARDUINO
+
+//#############################################################################
+// Includes
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <termios.h>
+
+#include "./host_serial.h"
+
+
+//#############################################################################
+// Function Definitions
+//-----------------------------------------------------------------------------
+static speed_t host_serial_speed(uint32_t Baud){
+	switch (Baud){
+		case 9600:		return B9600;
+		case 19200:		return B19200;
+		case 38400:		return B38400;
+		case 57600:		return B57600;
+		case 115200:	return B115200;
+		case 230400:	return B230400;
+		case 460800:	return B460800;
+		case 921600:	return B921600;
+		case 1000000:	return B1000000;
+		case 2000000:	return B2000000;
+		default:		return B115200;
+	}
+}
+
+//-----------------------------------------------------------------------------
+int host_serial_open(const char *pPath, uint32_t Baud){
+	struct termios tio;
+	int fd;
+
+	fd = open(pPath, O_RDWR | O_NOCTTY);
+	if (fd < 0){
+		return -1;
+	}
+
+	// a pty has no line settings worth failing over
+	if (tcgetattr(fd, &tio) == 0){
+		cfmakeraw(&tio);
+		cfsetispeed(&tio, host_serial_speed(Baud));
+		cfsetospeed(&tio, host_serial_speed(Baud));
+		tio.c_cflag |= (CLOCAL | CREAD);
+		tio.c_cc[VMIN] = 0;
+		tio.c_cc[VTIME] = 0;
+		tcsetattr(fd, TCSANOW, &tio);
+	}
+
+	return fd;
+}
+
+//-----------------------------------------------------------------------------
+int host_serial_read(int Fd, uint8_t *pData, size_t Length, int TimeoutMs){
+	struct pollfd pfd;
+	size_t done;
+	ssize_t n;
+
+	done = 0;
+	while (done < Length){
+		pfd.fd = Fd;
+		pfd.events = POLLIN;
+		n = poll(&pfd, 1, TimeoutMs);
+		if (n < 0){
+			if (errno == EINTR){
+				continue;
+			}
+			return -1;
+		}
+		if (n == 0){
+			break;
+		}
+
+		n = read(Fd, pData + done, Length - done);
+		if (n < 0){
+			if ((errno == EINTR) || (errno == EAGAIN)){
+				continue;
+			}
+			return -1;
+		}
+		if (n == 0){
+			break;
+		}
+		done += (size_t)n;
+	}
+
+	return (int)done;
+}
+
+//-----------------------------------------------------------------------------
+int host_serial_write(int Fd, const uint8_t *pData, size_t Length){
+	ssize_t n;
+
+	while (Length != 0){
+		n = write(Fd, pData, Length);
+		if (n < 0){
+			if ((errno == EINTR) || (errno == EAGAIN)){
+				continue;
+			}
+			return -1;
+		}
+		pData += n;
+		Length -= (size_t)n;
+	}
+
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+int host_serial_command(int Fd, const char *pLine){
+	if (host_serial_write(Fd, (const uint8_t *)pLine, strlen(pLine)) != 0){
+		return -1;
+	}
+	return host_serial_write(Fd, (const uint8_t *)"\r", 1);
+}
+
+//-----------------------------------------------------------------------------
+void host_serial_flush(int Fd){
+	uint8_t buf[256];
+
+	tcflush(Fd, TCIFLUSH);
+	while (host_serial_read(Fd, buf, sizeof(buf), 50) > 0);
+}
+
+#endif  /* ARDUINO */
@@ -0,0 +1,82 @@
+/**
+* @file host_serial.h
+*
+* @brief Host-side (Linux) serial port helpers for the Chicago debug console _H
+*
+* @copyright
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* @copyright
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* @author Adam Munich
+*/
+
+#ifndef __HOST_SERIAL_H__
+	#define __HOST_SERIAL_H__
+
+	//#############################################################################
+	// Includes
+	//-----------------------------------------------------------------------------
+	#include <stdint.h>
+	#include <stddef.h>
+
+
+	//#############################################################################
+	// Function Prototypes
+	//-----------------------------------------------------------------------------
+	/**
+	 * @brief 
+	 *		Open a tty (or pty) in raw 8N1 mode
+	 * @param pPath - Device path, e.g. /dev/ttyACM0
+	 * @param Baud - Baud rate; ignored by USB CDC devices
+	 * @return int - File descriptor, negative on error
+	 */
+	int host_serial_open(const char *pPath, uint32_t Baud);
+
+	/**
+	 * @brief 
+	 *		Read exactly Length bytes unless the line goes quiet
+	 * @param Fd - Descriptor from host_serial_open()
+	 * @param pData - Destination buffer
+	 * @param Length - Number of bytes wanted
+	 * @param TimeoutMs - Longest gap allowed between two bytes
+	 * @return int - Number of bytes read, less than Length on timeout, negative on error
+	 */
+	int host_serial_read(int Fd, uint8_t *pData, size_t Length, int TimeoutMs);
+
+	/**
+	 * @brief 
+	 *		Write all of pData
+	 * @param Fd - Descriptor from host_serial_open()
+	 * @param pData - Data to send
+	 * @param Length - Number of bytes in pData
+	 * @return int - 0 if success, negative on error
+	 */
+	int host_serial_write(int Fd, const uint8_t *pData, size_t Length);
+
+	/**
+	 * @brief 
+	 *		Send one debug console command line, terminated with CR
+	 * @param Fd - Descriptor from host_serial_open()
+	 * @param pLine - Command, e.g. "\\readbin 0 10000"
+	 * @return int - 0 if success, negative on error
+	 */
+	int host_serial_command(int Fd, const char *pLine);
+
+	/**
+	 * @brief 
+	 *		Drop anything already received
+	 * @param Fd - Descriptor from host_serial_open()
+	 * @return void
+	 */
+	void host_serial_flush(int Fd);
+
+#endif  /* __HOST_SERIAL_H__ */
@@ -0,0 +1,375 @@
+/**
+* @file ocm_pack.cpp
+*
+* @brief Host-side packer for the embedded OCM firmware image
+*
+* @copyright
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation; either
+* version 3.0 of the License, or (at your option) any later version.
+*
+* @copyright
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* @author Adam Munich
+*/
+
+/**
+* @details
+*	Reads the "0xNN, 0xNN, ..." byte list that Analogix ships as ocm_hex.h
+*	and writes ocm_pack.h in the format decoded by Flash/ocmImage.cpp, plus
+*	ocm_info.h with the size, CRC32 and version of the unpacked image so the
+*	firmware never has to unpack it to answer those.
+*	This file is not part of the Arduino build.
+*
+*		g++ -o ocm_pack Host/ocm_pack.cpp Flash/crc32.cpp
+*		./ocm_pack Flash/ocm_hex.h Flash/ocm_pack.h Flash/ocm_info.h
+*
+*	-s and -k add the secure OCM firmware and the HDCP key partition, in the
+*	same byte list format, to the bundle that burn_hex_auto() programs:
+*
+*		./ocm_pack -s secure_hex.h -k hdcp_key_hex.h Flash/ocm_hex.h \
+*			Flash/ocm_pack.h Flash/ocm_info.h
+*/
+
+#ifndef ARDUINO
+
+//#############################################################################
+// Includes
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <vector>
+
+#include "../Flash/ocmImage.h"
+#include "../Flash/crc32.h"
+#include "../Flash/flash.h"
+
+
+//#############################################################################
+// Type Definitions
+//-----------------------------------------------------------------------------
+typedef struct
+{
+	uint8_t  id;					// MAIN_OCM, SECURE_OCM or HDCP_14_22_KEY
+	uint32_t pack_offset;
+	uint32_t crc;
+	std::vector<uint8_t> image;
+} tagPackPartition;
+
+
+//#############################################################################
+// Function Definitions
+//-----------------------------------------------------------------------------
+static int load_byte_list(const char *pPath, std::vector<uint8_t> &Image){
+	FILE *fp;
+	int c;
+	int prev;
+	char token[8];
+	uint8_t n;
+
+	fp = fopen(pPath, "r");
+	if (fp == NULL){
+		return -1;
+	}
+
+	prev = 0;
+	while ((c = fgetc(fp)) != EOF){
+
+		// skip C and C++ comments
+		if ((prev == '/') && (c == '/')){
+			while (((c = fgetc(fp)) != EOF) && (c != '\n'));
+			prev = 0;
+			continue;
+		}
+		if ((prev == '/') && (c == '*')){
+			prev = 0;
+			while ((c = fgetc(fp)) != EOF){
+				if ((prev == '*') && (c == '/')){
+					break;
+				}
+				prev = c;
+			}
+			prev = 0;
+			continue;
+		}
+
+		if ((prev == '0') && ((c == 'x') || (c == 'X'))){
+			n = 0;
+			while (((c = fgetc(fp)) != EOF) && isxdigit(c) && (n < 2)){
+				token[n++] = (char)c;
+			}
+			token[n] = '\0';
+			if (n == 0){
+				fclose(fp);
+				return -2;
+			}
+			Image.push_back((uint8_t)strtol(token, NULL, 16));
+			if (c == EOF){
+				break;
+			}
+		}
+
+		prev = c;
+	}
+
+	fclose(fp);
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+static uint32_t fill_length(const std::vector<uint8_t> &Image, uint32_t Pos){
+	uint32_t n;
+
+	n = 0;
+	while ((Pos + n < Image.size()) && (Image[Pos + n] == 0xFF) && (n < OCM_IMAGE_FILL_MAX)){
+		n++;
+	}
+
+	return n;
+}
+
+//-----------------------------------------------------------------------------
+static uint32_t match_length(const std::vector<uint8_t> &Image, uint32_t Pos, uint32_t *pDistance){
+	uint32_t best;
+	uint32_t distance;
+	uint32_t n;
+
+	best = 0;
+	for (distance = 1; (distance <= OCM_IMAGE_WINDOW_SIZE) && (distance <= Pos); distance++){
+		n = 0;
+		// overlapping copies are fine, the decoder works byte by byte
+		while ((Pos + n < Image.size()) && (n < OCM_IMAGE_MATCH_MAX) &&
+			   (Image[Pos + n] == Image[Pos + n - distance])){
+			n++;
+		}
+		if (n > best){
+			best = n;
+			*pDistance = distance;
+		}
+	}
+
+	return best;
+}
+
+//-----------------------------------------------------------------------------
+static void flush_literals(std::vector<uint8_t> &Packed, const std::vector<uint8_t> &Image, uint32_t Start, uint32_t End){
+	uint32_t n;
+
+	while (Start < End){
+		n = End - Start;
+		if (n > OCM_IMAGE_LITERAL_MAX){
+			n = OCM_IMAGE_LITERAL_MAX;
+		}
+		Packed.push_back((uint8_t)(n - 1));
+		Packed.insert(Packed.end(), Image.begin() + Start, Image.begin() + Start + n);
+		Start += n;
+	}
+}
+
+//-----------------------------------------------------------------------------
+static void pack_image(const std::vector<uint8_t> &Image, std::vector<uint8_t> &Packed){
+	uint32_t pos;
+	uint32_t literal_start;
+	uint32_t fill;
+	uint32_t match;
+	uint32_t distance;
+	uint32_t size;
+
+	size = (uint32_t)Image.size();
+
+	Packed.push_back(OCM_IMAGE_MAGIC_0);
+	Packed.push_back(OCM_IMAGE_MAGIC_1);
+	Packed.push_back(OCM_IMAGE_FORMAT_VERSION);
+	Packed.push_back((uint8_t)(size));
+	Packed.push_back((uint8_t)(size >> 8));
+	Packed.push_back((uint8_t)(size >> 16));
+	Packed.push_back((uint8_t)(size >> 24));
+
+	pos = 0;
+	literal_start = 0;
+	while (pos < size){
+		fill = fill_length(Image, pos);
+		match = 0;
+		distance = 0;
+		if (fill < OCM_IMAGE_MATCH_MAX){
+			match = match_length(Image, pos, &distance);
+		}
+
+		if ((fill >= OCM_IMAGE_MATCH_MIN) && (fill >= match)){
+			flush_literals(Packed, Image, literal_start, pos);
+			Packed.push_back((uint8_t)(OCM_IMAGE_TOKEN_FILL | ((fill - 1) >> 8)));
+			Packed.push_back((uint8_t)(fill - 1));
+			pos += fill;
+			literal_start = pos;
+		}
+		else if (match >= OCM_IMAGE_MATCH_MIN){
+			flush_literals(Packed, Image, literal_start, pos);
+			Packed.push_back((uint8_t)(OCM_IMAGE_TOKEN_MATCH | (match - OCM_IMAGE_MATCH_MIN)));
+			Packed.push_back((uint8_t)(distance - 1));
+			pos += match;
+			literal_start = pos;
+		}
+		else{
+			pos++;
+		}
+	}
+	flush_literals(Packed, Image, literal_start, pos);
+}
+
+//-----------------------------------------------------------------------------
+static int write_byte_list(const char *pPath, const char *pSource, size_t ImageSize, const std::vector<uint8_t> &Packed){
+	FILE *fp;
+	size_t i;
+
+	fp = fopen(pPath, "w");
+	if (fp == NULL){
+		return -1;
+	}
+
+	fprintf(fp, "// Generated by Host/ocm_pack.cpp from %s, do not edit\n", pSource);
+	fprintf(fp, "// %lu bytes unpacked, %lu bytes packed\n", (unsigned long)ImageSize, (unsigned long)Packed.size());
+
+	for (i = 0; i < Packed.size(); i++){
+		fprintf(fp, "0x%02X,%s", Packed[i], (((i % 16) == 15) || (i == Packed.size() - 1)) ? "\n" : " ");
+	}
+
+	fclose(fp);
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+static void get_version(const tagPackPartition &Part, uint8_t *pVersion){
+	uint8_t i;
+
+	// only firmware carries a version, key data reads 0.0.00
+	for (i = 0; i < 3; i++){
+		pVersion[i] = 0;
+		if ((Part.id != HDCP_14_22_KEY) && ((size_t)(OCM_IMAGE_VERSION_OFFSET + i) < Part.image.size())){
+			pVersion[i] = Part.image[OCM_IMAGE_VERSION_OFFSET + i];
+		}
+	}
+	pVersion[0] &= 0x0F;
+	pVersion[1] &= 0x0F;
+}
+
+//-----------------------------------------------------------------------------
+static int write_info(const char *pPath, const char *pSource, const std::vector<tagPackPartition> &Parts){
+	FILE *fp;
+	uint8_t version[3];
+	size_t i;
+
+	fp = fopen(pPath, "w");
+	if (fp == NULL){
+		return -1;
+	}
+
+	// the main OCM firmware is always first
+	get_version(Parts[0], &version[0]);
+
+	fprintf(fp, "// Generated by Host/ocm_pack.cpp from %s, do not edit\n", pSource);
+	fprintf(fp, "#define OCM_INFO_SIZE					0x%08lXUL\n", (unsigned long)Parts[0].image.size());
+	fprintf(fp, "#define OCM_INFO_CRC32					0x%08lXUL\n", (unsigned long)Parts[0].crc);
+	fprintf(fp, "#define OCM_INFO_VERSION_MAJOR			0x%02X\n", version[0]);
+	fprintf(fp, "#define OCM_INFO_VERSION_MINOR			0x%02X\n", version[1]);
+	fprintf(fp, "#define OCM_INFO_VERSION_BUILD			0x%02X\n", version[2]);
+
+	// tagOcmPartitionInfo initializers
+	fprintf(fp, "#define OCM_INFO_PARTITIONS \\\n");
+	for (i = 0; i < Parts.size(); i++){
+		get_version(Parts[i], &version[0]);
+		fprintf(fp, "\t{ %u, 0x%08lXUL, 0x%08lXUL, 0x%08lXUL, { 0x%02X, 0x%02X, 0x%02X } }%s\n",
+				Parts[i].id, (unsigned long)Parts[i].pack_offset, (unsigned long)Parts[i].image.size(),
+				(unsigned long)Parts[i].crc, version[0], version[1], version[2],
+				(i == Parts.size() - 1) ? "" : ", \\");
+	}
+
+	fclose(fp);
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+static int add_partition(std::vector<tagPackPartition> &Parts, std::vector<uint8_t> &Packed, uint8_t Id, const char *pPath){
+	tagPackPartition part;
+
+	part.id = Id;
+	if ((load_byte_list(pPath, part.image) != 0) || part.image.empty()){
+		fprintf(stderr, "%s: can't read byte list\n", pPath);
+		return -1;
+	}
+
+	part.crc = crc32_update(CRC32_INITIAL, &part.image[0], (uint32_t)part.image.size());
+	part.pack_offset = (uint32_t)Packed.size();
+	pack_image(part.image, Packed);
+
+	printf("partition %u: %lu -> %lu bytes\n", Id, (unsigned long)part.image.size(),
+		   (unsigned long)(Packed.size() - part.pack_offset));
+
+	Parts.push_back(part);
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, char **argv){
+	std::vector<tagPackPartition> parts;
+	std::vector<uint8_t> packed;
+	const char *secure_path = NULL;
+	const char *key_path = NULL;
+	size_t total;
+	size_t i;
+	int arg;
+
+	for (arg = 1; (arg + 1 < argc) && (argv[arg][0] == '-'); arg += 2){
+		if (strcmp(argv[arg], "-s") == 0){
+			secure_path = argv[arg + 1];
+		}
+		else if (strcmp(argv[arg], "-k") == 0){
+			key_path = argv[arg + 1];
+		}
+		else{
+			break;
+		}
+	}
+
+	if (argc - arg != 3){
+		fprintf(stderr, "usage: %s [-s secure_hex.h] [-k hdcp_key_hex.h] <ocm_hex.h> <ocm_pack.h> <ocm_info.h>\n", argv[0]);
+		return 1;
+	}
+
+	if ((add_partition(parts, packed, MAIN_OCM, argv[arg]) != 0) ||
+		((secure_path != NULL) && (add_partition(parts, packed, SECURE_OCM, secure_path) != 0)) ||
+		((key_path != NULL) && (add_partition(parts, packed, HDCP_14_22_KEY, key_path) != 0))){
+		return 1;
+	}
+
+	total = 0;
+	for (i = 0; i < parts.size(); i++){
+		total += parts[i].image.size();
+	}
+
+	if (write_byte_list(argv[arg + 1], argv[arg], total, packed) != 0){
+		fprintf(stderr, "%s: can't write\n", argv[arg + 1]);
+		return 1;
+	}
+
+	if (write_info(argv[arg + 2], argv[arg], parts) != 0){
+		fprintf(stderr, "%s: can't write\n", argv[arg + 2]);
+		return 1;
+	}
+
+	printf("%lu -> %lu bytes (%.1f%%)\n", (unsigned long)total, (unsigned long)packed.size(),
+		   100.0 * (double)packed.size() / (double)total);
+
+	return 0;
+}
+
+#endif  /* ARDUINO */
@@ -171,6 +171,45 @@ int8_t i2c_read_block(uint8_t SlaveID, uint16_t Offset, uint8_t *pData, uint32_t
 	return RETURN_FAILURE_VALUE;
 }
 
+//-----------------------------------------------------------------------------
+int8_t i2c_write_block(uint8_t SlaveID, uint16_t Offset, const uint8_t *pData, uint32_t Length){
+	uint8_t n;
+
+	// Check SlaveId and Offset
+	if(((SlaveID & 0x0F) !=0) && ((Offset & 0xFF00) != 0) || ((Offset & 0xF000) != 0)) {
+		return RETURN_FAILURE_VALUE;
+	}
+
+	// the page is selected once, the block must not run past it
+	if(((Offset & 0x00FF) + Length) > 0x0100) {
+		return RETURN_FAILURE_VALUE;
+	}
+
+	if(RETURN_NORMAL_VALUE != WriteReg(CHICAGO_SLAVEID_ADDR, 0x00, (SlaveID | (uint8_t)((Offset & 0x0F00) >> 8)) )) {
+		#ifdef DEBUG_LEVEL_2
+		TRACE2("\tI2C write SLAVEID ERROR!! %02X %03X\n", SlaveID, Offset);
+		#endif
+		return RETURN_FAILURE_VALUE;
+	}
+
+	while(Length > 0) {
+		n = (Length > I2C_WRITE_BLOCK_MAX) ? I2C_WRITE_BLOCK_MAX : (uint8_t)Length;
+
+		if(RETURN_NORMAL_VALUE != WriteBlockReg(CHICAGO_OFFSET_ADDR, (uint8_t)(Offset & 0x00FF), n, pData)) {
+			#ifdef DEBUG_LEVEL_2
+			TRACE2("\tI2C write OFFSET ERROR!! %02X %03X\n", SlaveID, Offset);
+			#endif
+			return RETURN_FAILURE_VALUE;
+		}
+
+		Offset += n;
+		pData += n;
+		Length -= n;
+	}
+
+	return RETURN_NORMAL_VALUE;
+}
+
 //-----------------------------------------------------------------------------
 /// @copydoc ReadReg
 static int8_t ReadReg(uint8_t DevAddr, uint16_t RegAddr, uint8_t *pData){
@@ -331,6 +370,27 @@ static int8_t WriteReg4(uint8_t DevAddr, uint16_t RegAddr, uint32_t RegVal){
 	}	
 }
 
+//-----------------------------------------------------------------------------
+/// @copydoc WriteBlockReg
+static int8_t WriteBlockReg(uint8_t DevAddr, uint16_t RegAddr, uint8_t n, const uint8_t *pBuf){
+
+	// 7 bit address
+	DevAddr = (DevAddr >> 1);
+
+	Wire.beginTransmission(DevAddr);
+	Wire.write((uint8_t)RegAddr);
+	Wire.write(pBuf, n);
+
+	uint8_t result = Wire.endTransmission();
+
+	if(result == 0){	// Ack
+		return RETURN_NORMAL_VALUE;
+	}
+	else{				// Nack
+		return RETURN_FAILURE_VALUE;
+	}
+}
+
 //-----------------------------------------------------------------------------
 int8_t i2c1_write_byte(uint8_t addr, uint16_t Offset, uint8_t Data){
 	
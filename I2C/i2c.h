@@ -38,7 +38,8 @@
 	//#############################################################################
 	// Pre-compiler Definitions
 	//-----------------------------------------------------------------------------
-
+	// Wire buffers 32 bytes per transmission, one of which is the register address
+	#define I2C_WRITE_BLOCK_MAX		16
 
 	//#############################################################################
 	// Type Definitions
@@ -116,6 +117,22 @@
 	 */	
 	int8_t i2c_read_block(uint8_t SlaveID, uint16_t Offset, uint8_t *pData, uint32_t Length);
 
+	/**
+	 * @brief 
+	 *		Write block of registers to Chicago wire (Chicago abstraction)
+	 * @details
+	 *		Registers auto-increment, so the slave ID is selected once and the
+	 *		data goes out in bursts of I2C_WRITE_BLOCK_MAX bytes.
+	 * @ingroup Chicago_i2c
+	 * @param SlaveID - Chicago Slave ID
+	 * @param Offset - Register Address Offset (12 Bit)
+	 * @param pData - Register data (uint8_t array)
+	 * @param Length - Size of uint8_t array
+	 * @return RETURN_NORMAL_VALUE if success
+	 * @return RETURN_FAILURE_VALUE if fail
+	 */	
+	int8_t i2c_write_block(uint8_t SlaveID, uint16_t Offset, const uint8_t *pData, uint32_t Length);
+
 	/**
 	 * @brief 
 	 *		Read byte from register (directly)
@@ -177,6 +194,19 @@
 	 */		
 	static int8_t WriteReg4(uint8_t DevAddr, uint16_t RegAddr, uint32_t RegVal);
 
+	/**
+	 * @brief 
+	 *		Write block of registers (directly)
+	 * @ingroup Chicago_i2c
+	 * @param DevAddr - Device address
+	 * @param RegAddr - Register address
+	 * @param n - Number of bytes to write, up to I2C_WRITE_BLOCK_MAX
+	 * @param pBuf - Register data char array
+	 * @return RETURN_NORMAL_VALUE if success
+	 * @return RETURN_FAILURE_VALUE if fail
+	 */		
+	static int8_t WriteBlockReg(uint8_t DevAddr, uint16_t RegAddr, uint8_t n, const uint8_t *pBuf);
+
 	/**
 	 * @brief 
 	 *		Write byte to accessory wire (Chicago abstraction)